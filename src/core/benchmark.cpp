@@ -0,0 +1,309 @@
+#include "benchmark.h"
+#include "browser.h"
+#include "historystore.h"
+#include "processmemory.h"
+#include "profile.h"
+#include "tabchrome.h"
+#include "startupconfig.h"
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QFile>
+#include <QHBoxLayout>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QTcpSocket>
+#include <QTimer>
+#include <algorithm>
+#include <cstdio>
+
+static QJsonObject summarize(QList<double> samples, const QString &unit) {
+    QJsonObject o;
+    if (samples.isEmpty()) return o;
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double s : std::as_const(samples)) sum += s;
+    o["mean" + unit] = sum / samples.size();
+    o["p50" + unit] = samples.at(samples.size() / 2);
+    o["p95" + unit] = samples.at(qMin(int(samples.size()) - 1, int(samples.size() * 0.95)));
+    o["max" + unit] = samples.last();
+    return o;
+}
+
+Benchmark::Benchmark(const QElapsedTimer &launched, const QString &outputPath, QObject *parent)
+    : QObject(parent), launched(launched), outputPath(outputPath) {
+    connect(&fixture, &QTcpServer::newConnection, this, &Benchmark::serveFixture);
+}
+
+Benchmark::~Benchmark() {
+    delete window;
+}
+
+bool Benchmark::start() {
+    if (!fixture.listen(QHostAddress::LocalHost, 0)) return false;
+    QTimer::singleShot(0, this, &Benchmark::run);
+    return true;
+}
+
+QUrl Benchmark::fixtureUrl(int page) const {
+    return QUrl(QString("http://127.0.0.1:%1/page/%2").arg(fixture.serverPort()).arg(page));
+}
+
+// A fixed, moderately sized document so that runs only differ in the browser.
+void Benchmark::serveFixture() {
+    while (QTcpSocket *socket = fixture.nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, socket, [socket]() {
+            const QByteArray request = socket->peek(socket->bytesAvailable());
+            if (!request.contains("\r\n\r\n")) return;
+            socket->readAll();
+            const QByteArray path = request.split(' ').value(1);
+
+            QByteArray body = "<!DOCTYPE html><html><head><title>Fixture " + path + "</title>"
+                              "<style>body { font-family: sans-serif; margin: 40px; } p { line-height: 1.5; }</style>"
+                              "</head><body><h1>Fixture</h1>";
+            for (int i = 0; i < 200; ++i)
+                body += "<p>Paragraph " + QByteArray::number(i) + ": the quick brown fox jumps over the lazy dog.</p>";
+            body += "</body></html>";
+
+            socket->write("HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=utf-8\r\nCache-Control: no-store\r\n"
+                          "Connection: close\r\nContent-Length: " + QByteArray::number(body.size()) + "\r\n\r\n" + body);
+            socket->disconnectFromHost();
+        });
+    }
+}
+
+bool Benchmark::waitUntil(const std::function<bool()> &done, int timeoutMs) {
+    QElapsedTimer clock;
+    clock.start();
+    QEventLoop loop;
+    while (!done()) {
+        if (clock.elapsed() > timeoutMs) return false;
+        QTimer::singleShot(5, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+    return true;
+}
+
+void Benchmark::sampleMemory() {
+    peakRss = qMax(peakRss, processResidentBytes(QCoreApplication::applicationPid()));
+}
+
+void Benchmark::run() {
+    QJsonObject result;
+    result["qt"] = qVersion();
+    result["engine"] = StartupConfig::active().toJson();
+
+    // No restored session or start page: the first tab goes straight to the fixture.
+    window = new Browser(Profile::offTheRecord(), nullptr, false);
+    window->resize(1280, 800);
+    window->show();
+    TabManager *tabs = window->tabManager();
+
+    bool loaded = false;
+    {
+        QObject scope;
+        const QUrl target = fixtureUrl(0);
+        QWebEngineView *first = tabs->createNewTab(target);
+        connect(first, &QWebEngineView::loadFinished, &scope, [&loaded, first, target](bool ok) {
+            if (ok && first->url() == target) loaded = true;
+        });
+        waitUntil([&loaded]() { return loaded; }, 30000);
+    }
+    result["startupToFirstLoadMs"] = loaded ? QJsonValue(launched.elapsed()) : QJsonValue();
+    sampleMemory();
+
+    QJsonArray tabRuns;
+    for (int count : {1, 10, 100}) tabRuns.append(measureTabs(count));
+    result["createNewTab"] = tabRuns;
+    result["massReload"] = measureMassReload(50);
+    result["history"] = measureHistory(100000);
+    result["themeSwitch"] = measureThemeSwitch(50, 100);
+    sampleMemory();
+    result["peakRssMB"] = double(peakRss) / (1024 * 1024);
+
+    const QByteArray json = QJsonDocument(result).toJson();
+    if (outputPath.isEmpty()) {
+        std::fwrite(json.constData(), 1, json.size(), stdout);
+        std::fflush(stdout);
+    } else {
+        QFile f(outputPath);
+        if (f.open(QIODevice::WriteOnly)) f.write(json);
+    }
+
+    delete window;
+    window = nullptr;
+    emit finished(loaded);
+}
+
+QJsonObject Benchmark::measureTabs(int count) {
+    TabManager *tabs = window->tabManager();
+    // Let the spare view pool refill so every run starts from the same state.
+    waitUntil([]() { return false; }, 1500);
+
+    QObject scope;
+    QList<double> createUs;
+    QList<QWebEngineView*> views;
+    int finished = 0;
+    QElapsedTimer all;
+    all.start();
+    for (int i = 0; i < count; ++i) {
+        QElapsedTimer t;
+        t.start();
+        QWebEngineView *view = tabs->createNewTab(fixtureUrl(i + 1));
+        createUs.append(t.nsecsElapsed() / 1000.0);
+        connect(view, &QWebEngineView::loadFinished, &scope, [&finished]() { finished++; }, Qt::SingleShotConnection);
+        views.append(view);
+    }
+    const bool complete = waitUntil([&finished, count]() { return finished == count; }, 30000 + 1000 * count);
+    const qint64 allLoaded = all.elapsed();
+    sampleMemory();
+    QSet<qint64> renderers;
+    for (QWebEngineView *view : std::as_const(views)) renderers.insert(view->page()->renderProcessPid());
+
+    for (QWebEngineView *view : std::as_const(views)) tabs->closeTab(tabs->indexOf(view));
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+
+    QJsonObject o = summarize(createUs, "Us");
+    o["renderers"] = int(renderers.size());
+    o["tabs"] = count;
+    o["allLoadedMs"] = complete ? QJsonValue(allLoaded) : QJsonValue();
+    return o;
+}
+
+// Reloads many tabs at once and reports how busy that keeps the GUI thread:
+// how late a 1 ms heartbeat runs, and how often and for how long the window
+// chrome is updated compared to the number of view signals behind it.
+QJsonObject Benchmark::measureMassReload(int count) {
+    TabManager *tabs = window->tabManager();
+    QObject scope;
+    QList<QWebEngineView*> views;
+    int finished = 0;
+    for (int i = 0; i < count; ++i) {
+        QWebEngineView *view = tabs->createNewTab(fixtureUrl(1000 + i));
+        connect(view, &QWebEngineView::loadFinished, &scope, [&finished]() { finished++; });
+        views.append(view);
+    }
+    waitUntil([&finished, count]() { return finished >= count; }, 30000 + 1000 * count);
+
+    finished = 0;
+    tabs->tabChrome()->resetStats();
+    QList<double> lateMs;
+    QElapsedTimer beat;
+    QTimer heartbeat;
+    heartbeat.setTimerType(Qt::PreciseTimer);
+    heartbeat.setInterval(1);
+    connect(&heartbeat, &QTimer::timeout, &scope, [&lateMs, &beat]() {
+        lateMs.append(qMax(0.0, beat.nsecsElapsed() / 1e6 - 1));
+        beat.restart();
+    });
+
+    QElapsedTimer all;
+    all.start();
+    beat.start();
+    heartbeat.start();
+    for (QWebEngineView *view : std::as_const(views)) view->reload();
+    const bool complete = waitUntil([&finished, count]() { return finished >= count; }, 30000 + 1000 * count);
+    const qint64 allLoaded = all.elapsed();
+    heartbeat.stop();
+    const TabChrome::Stats stats = tabs->tabChrome()->stats();
+    sampleMemory();
+
+    for (QWebEngineView *view : std::as_const(views)) tabs->closeTab(tabs->indexOf(view));
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+
+    QJsonObject o = summarize(lateMs, "HeartbeatLateMs");
+    o["tabs"] = count;
+    o["allLoadedMs"] = complete ? QJsonValue(allLoaded) : QJsonValue();
+    o["chromeEvents"] = stats.events;
+    o["chromeFlushes"] = stats.flushes;
+    o["chromeFlushMs"] = stats.flushNs / 1e6;
+    return o;
+}
+
+QJsonObject Benchmark::measureHistory(int entries) {
+    HistoryStore store(QString());
+    QElapsedTimer t;
+
+    t.start();
+    for (int i = 0; i < entries; ++i)
+        store.addVisit(QUrl(QString("https://site%1.example/page/%2").arg(i % 997).arg(i)), QString("Page %1").arg(i));
+    const double insertNs = double(t.nsecsElapsed()) / entries;
+
+    QRandomGenerator rng(42);
+    t.restart();
+    for (int i = 0; i < entries; ++i) {
+        const int n = rng.bounded(entries);
+        store.addVisit(QUrl(QString("https://site%1.example/page/%2").arg(n % 997).arg(n)), QString());
+    }
+    const double revisitNs = double(t.nsecsElapsed()) / entries;
+
+    int found = 0;
+    t.restart();
+    for (int i = 0; i < entries; ++i) {
+        const int n = rng.bounded(entries);
+        if (store.lookup(QUrl(QString("https://site%1.example/page/%2").arg(n % 997).arg(n))) >= 0) found++;
+    }
+    const double lookupNs = double(t.nsecsElapsed()) / entries;
+    sampleMemory();
+
+    return QJsonObject{{"entries", entries}, {"insertNs", insertNs}, {"revisitNs", revisitNs},
+                       {"lookupNs", lookupNs}, {"lookupHits", found}};
+}
+
+// Theme switches and widget creation with many tabs open, the cases a
+// window style sheet made expensive: every switch re-polished the whole
+// window, and every new widget was matched against the sheet.
+QJsonObject Benchmark::measureThemeSwitch(int rounds, int tabCount) {
+    TabManager *tabs = window->tabManager();
+    QObject scope;
+    QList<QWebEngineView*> views;
+    int finished = 0;
+    for (int i = 0; i < tabCount; ++i) {
+        QWebEngineView *view = tabs->createNewTab(fixtureUrl(2000 + i));
+        connect(view, &QWebEngineView::loadFinished, &scope, [&finished]() { finished++; }, Qt::SingleShotConnection);
+        views.append(view);
+    }
+    waitUntil([&finished, tabCount]() { return finished >= tabCount; }, 30000 + 1000 * tabCount);
+
+    QList<double> switchMs;
+    for (int i = 0; i < rounds; ++i) {
+        QElapsedTimer t;
+        t.start();
+        window->changeTheme(i % 2 ? "Dark" : "White");
+        QCoreApplication::processEvents();
+        switchMs.append(t.nsecsElapsed() / 1e6);
+    }
+
+    // Buttons and fields like the ones every prompt bar and download row adds,
+    // created, polished and shown inside the themed window.
+    QList<double> createUs;
+    for (int i = 0; i < rounds; ++i) {
+        QElapsedTimer t;
+        t.start();
+        auto *probe = new QWidget(window);
+        auto *layout = new QHBoxLayout(probe);
+        for (int j = 0; j < 10; ++j) {
+            layout->addWidget(new QPushButton("Allow", probe));
+            layout->addWidget(new QLineEdit(probe));
+        }
+        probe->show();
+        QCoreApplication::processEvents();
+        createUs.append(t.nsecsElapsed() / 1000.0 / 20);
+        delete probe;
+    }
+    sampleMemory();
+
+    for (QWebEngineView *view : std::as_const(views)) tabs->closeTab(tabs->indexOf(view));
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    window->changeTheme("Dark");
+
+    QJsonObject o = summarize(switchMs, "Ms");
+    o["widgetCreate"] = summarize(createUs, "Us");
+    o["rounds"] = rounds;
+    o["tabs"] = tabCount;
+    return o;
+}
@@ -0,0 +1,45 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QTcpServer>
+#include <QUrl>
+#include <functional>
+
+class Browser;
+
+// Behind --bench: drives a real window offscreen against an in-process HTTP
+// fixture and reports startup, tab creation, mass reload, history, theme
+// switch and memory figures as one JSON document, so releases can be compared run to run.
+class Benchmark : public QObject {
+    Q_OBJECT
+public:
+    Benchmark(const QElapsedTimer &launched, const QString &outputPath, QObject *parent = nullptr);
+    ~Benchmark();
+    bool start();
+
+signals:
+    // Once the results are written; ok is false if the first page never loaded.
+    void finished(bool ok);
+
+private:
+    QElapsedTimer launched;
+    QString outputPath;
+    QTcpServer fixture;
+    Browser *window = nullptr;
+    qint64 peakRss = 0;
+
+    void run();
+    QJsonObject measureTabs(int count);
+    QJsonObject measureMassReload(int count);
+    QJsonObject measureHistory(int entries);
+    QJsonObject measureThemeSwitch(int rounds, int tabCount);
+    bool waitUntil(const std::function<bool()> &done, int timeoutMs);
+    void sampleMemory();
+    QUrl fixtureUrl(int page) const;
+    void serveFixture();
+};
+
+#endif
@@ -1,4 +1,14 @@
 #include "browser.h"
+#include "userdata.h"
+#include "downloadmanager.h"
+#include "perftrace.h"
+#include "taboverview.h"
+#include "thumbnailcache.h"
+#include "sitedecisions.h"
+#include "promptbar.h"
+#include "litemode.h"
+#include "contentindex.h"
+#include "themeengine.h"
 #include <QToolBar>
 #include <QPushButton>
 #include <QApplication>
@@ -9,189 +19,257 @@
 #include <QWebEngineDownloadRequest>
 #include <QNetworkProxy>
 #include <QMenu>
-#include <QFileDialog>
 #include <QStandardPaths>
 #include <QMessageBox>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
-#include <QListWidget>
 #include <QLabel>
 #include <QFileInfo>
 #include <QProgressBar>
 #include <QDesktopServices>
 #include <QWebEngineCertificateError>
-
-class VideoWindow : public QMainWindow {
+#include <QCompleter>
+#include <QAbstractItemView>
+#include <QTimer>
+#include <QShortcut>
+#include <QWebChannel>
+#include <QCloseEvent>
+#include <QPointer>
+
+// Floating, always-on-top home for a tab's live view, so a playing video keeps
+// its decoder, buffer and position. Closing it hands the view back to its tab.
+class PipWindow : public QWidget {
 public:
-    VideoWindow(const QUrl &url, QWidget *parent = nullptr) : QMainWindow(parent) {
-        auto *view = new QWebEngineView(this);
-        setCentralWidget(view);
-        view->load(url);
-        setWindowFlags(Qt::Window | Qt::WindowStaysOnTopHint);
+    PipWindow(TabManager *tabs, QWebEngineView *view)
+        : QWidget(tabs->window(), Qt::Window | Qt::WindowStaysOnTopHint), tabs(tabs), view(view) {
+        setAttribute(Qt::WA_DeleteOnClose);
+        // A window does not inherit its parent's palette.
+        setPalette(tabs->window()->palette());
+        setWindowTitle(view->title());
+        placeholder = tabs->detach(view);
+
+        auto *layout = new QVBoxLayout(this);
+        layout->setContentsMargins(0, 0, 0, 0);
+        layout->addWidget(view);
+        view->show();
         resize(640, 360);
+
+        // Let the largest video fill the window; the original inline style is
+        // kept on the element so it can be put back.
+        view->page()->runJavaScript(
+            "(function () {"
+            "  var best = null, area = 0;"
+            "  document.querySelectorAll('video').forEach(function (v) {"
+            "    var a = v.clientWidth * v.clientHeight; if (a > area) { area = a; best = v; } });"
+            "  if (!best) return;"
+            "  best.dataset.capturePip = best.getAttribute('style') || '';"
+            "  best.style.cssText += ';position:fixed!important;inset:0!important;width:100vw!important;"
+            "height:100vh!important;max-width:none!important;z-index:2147483647!important;"
+            "background:#000!important;object-fit:contain!important';"
+            "})()");
+    }
+
+protected:
+    void closeEvent(QCloseEvent *event) override {
+        view->page()->runJavaScript(
+            "(function () {"
+            "  var v = document.querySelector('video[data-capture-pip]');"
+            "  if (!v) return;"
+            "  v.setAttribute('style', v.dataset.capturePip); delete v.dataset.capturePip;"
+            "})()");
+        if (placeholder && !tabs->reattach(view, placeholder)) delete view;
+        QWidget::closeEvent(event);
     }
+
+private:
+    TabManager *tabs;
+    QWebEngineView *view;
+    QPointer<QWidget> placeholder;
 };
 
-Browser::Browser(QWidget *parent) : QMainWindow(parent) {
-    setupProfile();
+Browser::Browser(Profile *profile, QWidget *parent, bool restoreTabs) : QMainWindow(parent), browserProfile(profile) {
+    profile->retain();
+    history = profile->history();
     setupProxy();
+    // Before any child exists, so widgets are created with the shared theme
+    // style and inherit the palette instead of being re-polished later.
+    applyTheme(profile->isOffTheRecord() ? "Private" : "Dark");
     setupUI();
 
-    connect(QWebEngineProfile::defaultProfile(), &QWebEngineProfile::downloadRequested,
-            this, &Browser::handleDownload);
-            
-    applyTheme("Dark");
-    tabs->createNewTab(QUrl("https://www.google.com"));
-}
-void Browser::handleSslErrors(QWebEngineCertificateError error) {
-    QMessageBox::StandardButton res = QMessageBox::warning(this, "SSL Error",
-        QString("The certificate for %1 is invalid: %2. Proceed?")
-        .arg(error.url().host())
-        .arg(error.description()), 
-        QMessageBox::Yes | QMessageBox::No);
-
-    if (res == QMessageBox::Yes) {
-        error.acceptCertificate();
-    } else {
-        error.rejectCertificate();
-    }
-}
+    // Every window of a profile sees its downloads; only the one owning the
+    // requesting page (or the active one, for page-less downloads) handles it.
+    connect(profile->web(), &QWebEngineProfile::downloadRequested, this, [this](QWebEngineDownloadRequest *download) {
+        if (download->page() ? ownsPage(download->page()) : isActiveWindow()) handleDownload(download);
+    });
 
-class DownloadNotification : public QWidget {
-    Q_OBJECT
-    QWebEngineDownloadRequest *m_download;
-    QProgressBar *m_bar;
-public:
-    DownloadNotification(QWebEngineDownloadRequest *download, QWidget *parent = nullptr) 
-        : QWidget(parent), m_download(download) {
-        setFixedSize(320, 110);
-        setStyleSheet("background: #1a1a1a; color: white; border: 1px solid #333; border-radius: 10px;");
-        
-        auto *layout = new QVBoxLayout(this);
-        auto *label = new QLabel("Downloading: " + download->suggestedFileName());
-        label->setWordWrap(true);
-        
-        m_bar = new QProgressBar;
-        m_bar->setStyleSheet("QProgressBar { height: 10px; border-radius: 5px; background: #333; } "
-                           "QProgressBar::chunk { background: #0078d4; }");
-
-        auto *btnLayout = new QHBoxLayout();
-        auto *openBtn = new QPushButton("Open");
-        auto *cancelBtn = new QPushButton("Cancel");
-        openBtn->setEnabled(false);
-        
-        btnLayout->addWidget(openBtn);
-        btnLayout->addWidget(cancelBtn);
-
-        layout->addWidget(label);
-        layout->addWidget(m_bar);
-        layout->addLayout(btnLayout);
-
-        connect(download, &QWebEngineDownloadRequest::receivedBytesChanged, this, [this, download]() {
-            int prog = (download->receivedBytes() * 100) / download->totalBytes();
-            m_bar->setValue(prog);
-        });
+    if (profile->isOffTheRecord()) setWindowTitle("Capture - Private");
+    else if (profile->name() != "Default") setWindowTitle("Capture - " + profile->name());
 
-        connect(download, &QWebEngineDownloadRequest::stateChanged, this, [this, openBtn, download](int state) {
-            if (state == 2) { 
-                openBtn->setEnabled(true);
-                m_bar->setValue(100);
-            }
-        });
+    if (profile->claimSession()) session = new SessionStore(profile->dataPath() + "/session.bin", tabs, this);
+    // A window opened to receive a torn-off tab starts out empty.
+    if (!restoreTabs) return;
+    if (!session || !session->restore()) tabs->createNewTab(QUrl("https://www.google.com"));
+}
 
-        connect(openBtn, &QPushButton::clicked, [this, download]() {
-            QDesktopServices::openUrl(QUrl::fromLocalFile(download->downloadDirectory()));
-            this->close();
-        });
+Browser::~Browser() {
+    browserProfile->release();
+}
 
-        connect(cancelBtn, &QPushButton::clicked, [this, download]() {
-            download->cancel();
-            this->close();
-        });
+bool Browser::ownsPage(QWebEnginePage *page) const {
+    for (int i = 0; i < tabs->count(); ++i) {
+        auto *view = qobject_cast<QWebEngineView*>(tabs->widget(i));
+        if (view && view->page() == page) return true;
+    }
+    return false;
+}
 
-        move(parent->width() - 340, 40);
-        show();
+void Browser::openProfileWindow(const QString &name) {
+    if (browserProfile->isOffTheRecord() && name == browserProfile->name()) {
+        openPrivateWindow();
+        return;
     }
-};
+    Browser *w = new Browser(Profile::open(name));
+    w->setAttribute(Qt::WA_DeleteOnClose);
+    w->show();
+}
 
-void Browser::handleDownload(QWebEngineDownloadRequest *download) {
-    QString path = QFileDialog::getSaveFileName(this, "Save File", 
-        QStandardPaths::writableLocation(QStandardPaths::DownloadLocation) + "/" + download->suggestedFileName());
+void Browser::toggleOverview() {
+    if (overview->isVisible()) overview->hide();
+    else overview->open();
+}
 
-    if (path.isEmpty()) { download->cancel(); return; }
+Browser *Browser::openEmptyWindow() {
+    Browser *w = new Browser(browserProfile, nullptr, false);
+    w->setAttribute(Qt::WA_DeleteOnClose);
+    w->resize(size());
+    w->show();
+    return w;
+}
 
-    download->setDownloadDirectory(QFileInfo(path).path());
-    download->setDownloadFileName(QFileInfo(path).fileName());
-    download->accept();
+void Browser::moveTabToNewWindow(int index) {
+    if (tabs->count() < 2) return;
+    tabs->moveTab(index, openEmptyWindow()->tabManager());
+}
 
-    new DownloadNotification(download, this);
+void Browser::openPrivateWindow() {
+    Browser *w = new Browser(Profile::offTheRecord());
+    w->setAttribute(Qt::WA_DeleteOnClose);
+    w->show();
 }
+// Certificate and permission questions are answered from the profile's
+// stored decisions when possible; otherwise they wait on the tab's prompt bar
+// and the answer is remembered. Dismissing the bar answers "no" just this once.
+void Browser::handleSslErrors(QWebEngineView *view, QWebEngineCertificateError error) {
+    SiteDecisions *decisions = browserProfile->decisions();
+    if (!error.isOverridable()) {
+        error.rejectCertificate();
+        return;
+    }
+    switch (decisions->certificate(error)) {
+    case SiteDecisions::Allow: error.acceptCertificate(); return;
+    case SiteDecisions::Deny: error.rejectCertificate(); return;
+    case SiteDecisions::Ask: break;
+    }
 
-void Browser::setupProfile() {
-    QWebEngineProfile *p = QWebEngineProfile::defaultProfile();
+    error.defer();
+    PromptBar::forView(view)->ask("certificate:" + error.url().host(),
+        QString("The certificate for %1 is invalid: %2. Proceed?").arg(error.url().host(), error.description()),
+        "Proceed", "Go Back", [decisions, error](PromptBar::Answer answer) mutable {
+            if (answer != PromptBar::Dismissed) decisions->setCertificate(error, answer == PromptBar::Accepted);
+            if (answer == PromptBar::Accepted) error.acceptCertificate();
+            else error.rejectCertificate();
+        });
+}
 
-    QString ua = p->httpUserAgent();
-    ua.replace("QtWebEngine/6.8.0 ", ""); 
-    p->setHttpUserAgent(ua);
+void Browser::handlePermission(QWebEngineView *view, QWebEnginePermission permission) {
+    SiteDecisions *decisions = browserProfile->decisions();
+    switch (decisions->permission(permission)) {
+    case SiteDecisions::Allow: permission.grant(); return;
+    case SiteDecisions::Deny: permission.deny(); return;
+    case SiteDecisions::Ask: break;
+    }
 
-    QWebEngineSettings *s = p->settings();
-    s->setAttribute(QWebEngineSettings::LocalStorageEnabled, true);
-    s->setAttribute(QWebEngineSettings::JavascriptEnabled, true);
+    const QString type = SiteDecisions::permissionName(permission.permissionType());
+    PromptBar::forView(view)->ask(permission.origin().toString() + "|" + type,
+        QString("%1 wants to access your %2.").arg(permission.origin().host(), type),
+        "Allow", "Block", [decisions, permission](PromptBar::Answer answer) mutable {
+            if (answer != PromptBar::Dismissed) decisions->setPermission(permission, answer == PromptBar::Accepted);
+            if (answer == PromptBar::Accepted) permission.grant();
+            else permission.deny();
+        });
+}
 
-    p->setPersistentCookiesPolicy(QWebEngineProfile::ForcePersistentCookies);
+void Browser::handleDownload(QWebEngineDownloadRequest *) {
+    downloadPanel->reposition();
+    downloadPanel->show();
+    downloadPanel->raise();
 }
-void Browser::addHistoryEntry(const QUrl &url) {
-    QString urlStr = url.toString();
-    if (urlStr.startsWith("capture://") || urlStr.isEmpty()) return;
-    
-    historyList.removeAll(urlStr);
-    historyList.prepend(urlStr);
-    if (historyList.size() > 1000) historyList.removeLast();
+
+void Browser::addHistoryEntry(const QUrl &url, const QString &title) {
+    if (url.isEmpty() || url.scheme() == "capture" || url.scheme() == "data") return;
+    history->addVisit(url, title);
 }
 
 void Browser::showHistory() {
-    QDialog dlg(this);
-    dlg.setWindowTitle("History");
-    dlg.resize(500, 400);
-    dlg.setStyleSheet("background: #1a1a1a; color: white;");
-
-    QVBoxLayout *layout = new QVBoxLayout(&dlg);
-    QListWidget *list = new QListWidget;
-    list->addItems(historyList);
-    list->setStyleSheet("QListWidget { border: none; } QListWidget::item { padding: 8px; border-bottom: 1px solid #333; }");
-
-    connect(list, &QListWidget::itemDoubleClicked, [this, &dlg](QListWidgetItem *item) {
-        if (auto *v = qobject_cast<QWebEngineView*>(tabs->currentWidget())) {
-            v->load(QUrl(item->text()));
-            dlg.close();
-        }
-    });
-
-    layout->addWidget(new QLabel("Double-click to open:"));
-    layout->addWidget(list);
-    dlg.exec();
+    tabs->createNewTab(QUrl("capture://history"));
 }
 
 void Browser::clearData() {
-    QWebEngineProfile::defaultProfile()->clearHttpCache();
-    if (auto *store = QWebEngineProfile::defaultProfile()->cookieStore()) {
+    browserProfile->web()->clearHttpCache();
+    if (auto *store = browserProfile->web()->cookieStore()) {
         store->deleteAllCookies();
     }
-    historyList.clear();
+    history->clear();
+    browserProfile->decisions()->clear();
     QMessageBox::information(this, "Privacy", "All browsing data cleared.");
 }
+// Icon theme lookups are not free, so both badges are resolved once and the
+// label is only touched when the state actually flips.
 void Browser::updateSslIcon(const QUrl &url) {
-    if (url.scheme() == "https") {
-        sslLabel->setPixmap(QIcon::fromTheme("security-high").pixmap(16, 16));
-        sslLabel->setToolTip("Connection is Secure");
-    } else {
-        sslLabel->setPixmap(QIcon::fromTheme("security-low").pixmap(16, 16));
-        sslLabel->setToolTip("Connection is NOT Secure");
-    }
+    const int secure = url.scheme() == "https";
+    if (secure == sslState) return;
+    sslState = secure;
+    sslLabel->setPixmap(secure ? secureIcon : insecureIcon);
+    sslLabel->setToolTip(secure ? "Connection is Secure" : "Connection is NOT Secure");
+}
+
+void Browser::showUrl(const QUrl &url) {
+    const QString text = url.toString();
+    if (addressBar->text() != text) addressBar->setText(text);
+    updateSslIcon(url);
 }
+
 void Browser::setupUI() {
-    tabs = new TabManager(this);
+    tabs = new TabManager(browserProfile->web(), this);
     setCentralWidget(tabs);
+    tabs->webChannel()->registerObject(QStringLiteral("handler"), this);
+    tabs->webChannel()->registerObject(QStringLiteral("history"), history);
+    tabs->webChannel()->registerObject(QStringLiteral("downloads"), browserProfile->downloads());
+    tabs->webChannel()->registerObject(QStringLiteral("perf"), PerfTracer::instance());
+    tabs->webChannel()->registerObject(QStringLiteral("decisions"), browserProfile->decisions());
+    tabs->webChannel()->registerObject(QStringLiteral("lite"), browserProfile->lite());
+    tabs->webChannel()->registerObject(QStringLiteral("content"), browserProfile->content());
+    tabs->webChannel()->registerObject(QStringLiteral("themes"), ThemeEngine::instance());
+
+    LiteMode *lite = browserProfile->lite();
+    connect(tabs, &TabManager::viewCreated, lite, [lite](QWebEngineView *view) { lite->watch(view->page()); });
+    connect(tabs, &TabManager::pageAdopted, lite, [lite](QWebEngineView *view) { lite->watch(view->page()); });
+
+    // Previews are taken only from the visible tab, once it has settled.
+    ThumbnailCache *thumbnails = browserProfile->thumbnails();
+    overview = new TabOverview(tabs, thumbnails);
+    ContentIndex *content = browserProfile->content();
+    connect(tabs, &TabManager::viewCreated, this, [thumbnails, content](QWebEngineView *view) {
+        connect(view, &QWebEngineView::loadFinished, view, [view, thumbnails, content](bool ok) {
+            if (!ok) return;
+            QTimer::singleShot(500, view, [view, thumbnails]() { thumbnails->capture(view); });
+            content->index(view->page());
+        });
+    });
+    connect(tabs, &QTabWidget::currentChanged, this, [this, thumbnails]() {
+        if (auto *view = qobject_cast<QWebEngineView*>(tabs->currentWidget()))
+            QTimer::singleShot(500, view, [view, thumbnails]() { thumbnails->capture(view); });
+    });
     tabs->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(tabs, &QWidget::customContextMenuRequested, this, &Browser::showContextMenu);
 
@@ -208,9 +286,21 @@ void Browser::setupUI() {
     addressLayout->setSpacing(5);
 
     sslLabel = new QLabel(this);
-    sslLabel->setPixmap(QIcon::fromTheme("security-high").pixmap(16, 16));
+    secureIcon = QIcon::fromTheme("security-high").pixmap(16, 16);
+    insecureIcon = QIcon::fromTheme("security-low").pixmap(16, 16);
+    sslLabel->setPixmap(secureIcon);
     
     addressBar = new QLineEdit(this);
+    suggestions = new SuggestionModel(browserProfile->suggestions(), this);
+    suggestions->setContentIndex(browserProfile->content());
+    prerender = new Prerenderer(browserProfile->suggestions(), browserProfile->web(), this);
+    PerfTracer::instance()->addPrerenderer(prerender);
+    QCompleter *completer = new QCompleter(suggestions, this);
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    completer->setCompletionRole(Qt::EditRole);
+    addressBar->setCompleter(completer);
+    // The popup is a parentless window, so it is themed explicitly.
+    completer->popup()->setPalette(palette());
     
     addressLayout->addWidget(sslLabel);
     addressLayout->addWidget(addressBar);
@@ -221,7 +311,9 @@ void Browser::setupUI() {
     progressBar->setTextVisible(false);
     progressBar->hide();
 
+    QPushButton *overviewBtn = new QPushButton("▦");
     QPushButton *histBtn = new QPushButton("H");
+    QPushButton *downloadsBtn = new QPushButton("↓");
     QPushButton *settings = new QPushButton("⚙");
 
     nav->addWidget(backBtn);
@@ -229,32 +321,67 @@ void Browser::setupUI() {
     nav->addWidget(reloadBtn);
     nav->addWidget(addressContainer); 
     nav->addWidget(progressBar);
+    nav->addWidget(overviewBtn);
     nav->addWidget(histBtn);
+    nav->addWidget(downloadsBtn);
     nav->addWidget(settings);
 
     connect(backBtn, &QPushButton::clicked, [this](){ if(auto *v = qobject_cast<QWebEngineView*>(tabs->currentWidget())) v->back(); });
     connect(fwdBtn, &QPushButton::clicked, [this](){ if(auto *v = qobject_cast<QWebEngineView*>(tabs->currentWidget())) v->forward(); });
     connect(reloadBtn, &QPushButton::clicked, [this](){ if(auto *v = qobject_cast<QWebEngineView*>(tabs->currentWidget())) v->reload(); });
     connect(addressBar, &QLineEdit::returnPressed, this, &Browser::onReturnPressed);
+    connect(addressBar, &QLineEdit::textEdited, suggestions, &SuggestionModel::setQuery);
+    connect(addressBar, &QLineEdit::textEdited, prerender, &Prerenderer::predict);
+    connect(completer, QOverload<const QString &>::of(&QCompleter::activated), this, &Browser::queueNavigation);
     connect(histBtn, &QPushButton::clicked, this, &Browser::showHistory);
+    downloadPanel = new DownloadPanel(browserProfile->downloads(), this);
+    connect(downloadsBtn, &QPushButton::clicked, [this]() {
+        if (downloadPanel->isVisible()) {
+            downloadPanel->hide();
+        } else {
+            downloadPanel->reposition();
+            downloadPanel->show();
+            downloadPanel->raise();
+        }
+    });
+    connect(overviewBtn, &QPushButton::clicked, this, &Browser::toggleOverview);
     connect(settings, &QPushButton::clicked, [this]() { tabs->createNewTab(QUrl("capture://settings")); });
+    new QShortcut(QKeySequence("Ctrl+T"), this, [this]() { tabs->handleNewTabButtonClick(); });
+    new QShortcut(QKeySequence("Ctrl+W"), this, [this]() { tabs->closeTab(tabs->currentIndex()); });
+    new QShortcut(QKeySequence("Ctrl+Shift+A"), this, [this]() { toggleOverview(); });
+    new QShortcut(QKeySequence("Ctrl+N"), this, [this]() { openProfileWindow(browserProfile->name()); });
+    new QShortcut(QKeySequence("Ctrl+Shift+N"), this, [this]() { openPrivateWindow(); });
+    new QShortcut(QKeySequence("Ctrl+Shift+P"), this, [this]() { tabs->createNewTab(QUrl("capture://perf")); });
 }
 
 void Browser::showContextMenu(const QPoint &pos) {
     if (auto *view = qobject_cast<QWebEngineView*>(tabs->currentWidget())) {
         QMenu menu(this);
+        menu.setPalette(palette());
         menu.addAction(view->pageAction(QWebEnginePage::Back));
         menu.addAction(view->pageAction(QWebEnginePage::Forward));
         menu.addAction(view->pageAction(QWebEnginePage::Reload));
         menu.addSeparator();
         menu.addAction("Pop-out Video", [this, view]() {
-            auto *pip = new VideoWindow(view->url());
+            auto *pip = new PipWindow(tabs, view);
             pip->show();
         });
+        if (!view->url().host().isEmpty()) {
+            LiteMode *lite = browserProfile->lite();
+            QAction *action = menu.addAction("Lite Mode for This Site", [lite, view](bool on) {
+                lite->setLite(view->url().host(), on);
+                view->reload();
+            });
+            action->setCheckable(true);
+            action->setChecked(lite->isLite(view->url()));
+        }
+        if (tabs->count() > 1) {
+            menu.addAction("Move Tab to New Window", [this, view]() { moveTabToNewWindow(tabs->indexOf(view)); });
+        }
         menu.addAction("Inspect Element", [this, pos]() {
             if(auto *v = qobject_cast<QWebEngineView*>(tabs->currentWidget())) {
                 v->page()->setInspectedPage(v->page());
-                QDesktopServices::openUrl(QUrl("http://localhost:9222"));
+                QDesktopServices::openUrl(QUrl("http://localhost:" + qEnvironmentVariable("QTWEBENGINE_REMOTE_DEBUGGING", "9222")));
             }
         });
         menu.exec(tabs->mapToGlobal(pos));
@@ -262,72 +389,78 @@ void Browser::showContextMenu(const QPoint &pos) {
 }
 
 void Browser::onReturnPressed() {
-    QString val = addressBar->text();
+    queueNavigation(addressBar->text());
+}
+
+// Enter on a highlighted suggestion reaches us through both returnPressed and
+// QCompleter::activated; coalesce them into one navigation.
+void Browser::queueNavigation(const QString &val) {
+    const bool scheduled = !pendingNavigation.isEmpty();
+    pendingNavigation = val;
+    if (scheduled) return;
+    QTimer::singleShot(0, this, [this]() {
+        const QString target = pendingNavigation;
+        pendingNavigation.clear();
+        navigateTo(target);
+    });
+}
+
+void Browser::navigateTo(const QString &val) {
+    if (val.isEmpty()) return;
     if (auto *v = qobject_cast<QWebEngineView*>(tabs->currentWidget())) {
+        QUrl target;
         if (!val.contains(".") && !val.contains("://")) {
-            v->load(QUrl("https://www.google.com/search?q=" + val));
+            target = QUrl("https://www.google.com/search?q=" + val);
         } else {
-            v->load(QUrl::fromUserInput(val));
+            target = QUrl::fromUserInput(val);
+        }
+
+        bool loaded = false;
+        if (QWebEnginePage *page = prerender->take(target, &loaded)) {
+            tabs->adoptPage(v, page, loaded);
+        } else {
+            tabs->navigate(v, target);
         }
     }
 }
 
 void Browser::applyTheme(const QString &mode) {
-    if (mode == "White") {
-        qApp->setStyleSheet(
-            "QMainWindow { background: #ffffff; }"
-            "QToolBar { background: #f8f9fa; border-bottom: 1px solid #ddd; padding: 8px; spacing: 10px; }"
-            "QLineEdit { background: #f1f3f4; color: #202124; border-radius: 20px; padding: 6px 15px; border: 1px solid #dfe1e5; }"
-            "QPushButton { background: transparent; color: #5f6368; border-radius: 10px; padding: 5px 12px; }"
-            "QPushButton:hover { background: #e8eaed; color: #1a73e8; }"
-            "QTabWidget::pane { border: none; background: #ffffff; }"
-            "QTabBar::tab { background: #f1f3f4; color: #5f6368; padding: 10px 20px; border-top-left-radius: 8px; border-top-right-radius: 8px; }"
-            "QTabBar::tab:selected { background: #ffffff; color: #1a73e8; border-bottom: 2px solid #1a73e8; }"
-        );
-    } else if (mode == "Private") {
-        qApp->setStyleSheet(
-            "QMainWindow { background: #0d0216; }"
-            "QToolBar { background: #1a0b2e; border-bottom: 2px solid #bc13fe; padding: 8px; }"
-            "QLineEdit { background: #0d0216; color: #bc13fe; border: 1px solid #4b0082; border-radius: 20px; padding: 6px; }"
-            "QPushButton { color: #bc13fe; background: #1a0b2e; border: 1px solid #4b0082; border-radius: 10px; }"
-            "QPushButton:hover { background: #bc13fe; color: #000; }"
-            "QTabBar::tab:selected { background: #0d0216; color: #bc13fe; border-bottom: 2px solid #bc13fe; }"
-        );
-    } else {
-        qApp->setStyleSheet(
-            "QMainWindow { background: #0f0f0f; }"
-            "QToolBar { background: #1a1a1a; border-bottom: 1px solid #2d2d2d; padding: 8px; spacing: 10px; }"
-            "QLineEdit { background: #2b2b2b; color: #e8eaed; border-radius: 20px; padding: 6px 15px; border: 1px solid #3c4043; }"
-            "QPushButton { background: #2b2b2b; color: #bdc1c6; border: 1px solid #3c4043; border-radius: 10px; padding: 5px 12px; }"
-            "QPushButton:hover { background: #3c4043; color: #ffffff; border-color: #8ab4f8; }"
-            "QTabWidget::pane { border: none; background: #0f0f0f; }"
-            "QTabBar::tab { background: #1a1a1a; color: #9aa0a6; padding: 10px 20px; }"
-            "QTabBar::tab:selected { background: #2b2b2b; color: #8ab4f8; border-bottom: 2px solid #8ab4f8; }"
-        );
-    }
+    ThemeEngine::instance()->apply(this, mode);
+    if (addressBar && addressBar->completer()) addressBar->completer()->popup()->setPalette(palette());
 }
 
-
 void Browser::updateUI(int progress) {
-    progressBar->setValue(progress);
-    progressBar->setVisible(progress < 100);
+    if (progressBar->value() != progress) progressBar->setValue(progress);
+    if (progressBar->isHidden() == (progress < 100)) progressBar->setVisible(progress < 100);
 }
 
-void Browser::changeTheme(const QString &theme) { applyTheme(theme); }
+void Browser::changeTheme(const QString &theme) {
+    // Private mode is an off-the-record profile, not just a palette.
+    if (theme == "Private" && !browserProfile->isOffTheRecord()) {
+        openPrivateWindow();
+        return;
+    }
+    applyTheme(theme);
+}
 void Browser::setupProxy() { QNetworkProxy::setApplicationProxy(QNetworkProxy::NoProxy); }
 void Browser::setPrivacyLevel(const QString &level) {
-    QWebEngineSettings *s = QWebEngineProfile::defaultProfile()->settings();
-    QWebEngineProfile *p = QWebEngineProfile::defaultProfile();
+    QWebEngineProfile *p = browserProfile->web();
+    QWebEngineSettings *s = p->settings();
+    ContentBlocker *blocker = browserProfile->blocker();
+
+    blocker->setEnabled(level != "None");
+    blocker->setStrict(level == "Hardest");
 
     if (level == "Hardest") {
         s->setAttribute(QWebEngineSettings::JavascriptCanOpenWindows, false);
         s->setAttribute(QWebEngineSettings::JavascriptCanAccessClipboard, false);
         p->setPersistentCookiesPolicy(QWebEngineProfile::NoPersistentCookies);
         p->setHttpCacheType(QWebEngineProfile::MemoryHttpCache);
-    } else {
+    } else if (!browserProfile->isOffTheRecord()) {
         s->setAttribute(QWebEngineSettings::JavascriptCanOpenWindows, true);
         p->setPersistentCookiesPolicy(QWebEngineProfile::AllowPersistentCookies);
         p->setHttpCacheType(QWebEngineProfile::DiskHttpCache);
+    } else {
+        s->setAttribute(QWebEngineSettings::JavascriptCanOpenWindows, true);
     }
 }
-#include "browser.moc"
\ No newline at end of file
@@ -4,43 +4,74 @@
 #include <QMainWindow>
 #include <QLineEdit>
 #include <QProgressBar>
-#include <QStringList>
 #include <QWebEngineDownloadRequest>
-#include <QWebEngineCertificateError> 
+#include <QWebEngineCertificateError>
+#include <QWebEnginePermission>
 #include "tabmanager.h"
+#include "sessionstore.h"
+#include "historystore.h"
+#include "omnibox.h"
+#include "prerender.h"
+#include "contentblocker.h"
+#include "profile.h"
 #include <QHBoxLayout>
 #include <QLabel>
 
+class DownloadPanel;
+class TabOverview;
+
 class Browser : public QMainWindow {
     Q_OBJECT
 
 public:
-    explicit Browser(QWidget *parent = nullptr); 
+    explicit Browser(Profile *profile, QWidget *parent = nullptr, bool restoreTabs = true);
+    ~Browser();
+    Profile *profile() const { return browserProfile; }
+    TabManager *tabManager() const { return tabs; }
     
-    QLineEdit *addressBar;
+    QLineEdit *addressBar = nullptr;
     QLabel *sslLabel;
     QProgressBar *progressBar;
     void updateSslIcon(const QUrl &url);
+    void showUrl(const QUrl &url);
     void updateUI(int progress);
 public slots:
     void clearData();
     void changeTheme(const QString &theme);
     void setPrivacyLevel(const QString &level);
     void showHistory();
-    void handleSslErrors(QWebEngineCertificateError error); 
+    void handleSslErrors(QWebEngineView *view, QWebEngineCertificateError error);
+    void handlePermission(QWebEngineView *view, QWebEnginePermission permission);
     void handleDownload(QWebEngineDownloadRequest *download);
-    void addHistoryEntry(const QUrl &url);
+    void addHistoryEntry(const QUrl &url, const QString &title = QString());
+    void openProfileWindow(const QString &name);
+    void openPrivateWindow();
+    Browser *openEmptyWindow();
+    void moveTabToNewWindow(int index);
+    void toggleOverview();
 
 private:
+    Profile *browserProfile;
     TabManager *tabs;
-    QStringList historyList;
+    SessionStore *session = nullptr;
+    HistoryStore *history;
+    SuggestionModel *suggestions;
+    Prerenderer *prerender;
+    DownloadPanel *downloadPanel;
+    TabOverview *overview;
+    QString pendingNavigation;
     QHBoxLayout *addressLayout;
+    QPixmap secureIcon;
+    QPixmap insecureIcon;
+    int sslState = -1;
     void setupUI();
-    void setupProfile();
     void setupProxy();
     void applyTheme(const QString &mode);
     void onReturnPressed();
+    void queueNavigation(const QString &val);
+    void navigateTo(const QString &val);
     void showContextMenu(const QPoint &pos);
+    bool ownsPage(QWebEnginePage *page) const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,318 @@
+#include "contentblocker.h"
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QUrl>
+
+static bool isTokenChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '%';
+}
+
+static bool isSeparator(char c) {
+    return !(isTokenChar(c) || c == '_' || c == '-' || c == '.');
+}
+
+// Wildcard match of an ABP pattern ('*' any run, '^' separator or end) at u.
+// Iterative: on a mismatch only the most recent '*' takes one more character,
+// which is enough because everything between two '*'s has a fixed length.
+static bool matchAt(const char *p, const char *pe, const char *u, const char *ue, bool endAnchor) {
+    const char *starP = nullptr;
+    const char *starU = nullptr;
+    for (;;) {
+        if (p == pe) {
+            if (!endAnchor || u == ue) return true;
+        } else if (*p == '*') {
+            starP = ++p;
+            starU = u;
+            continue;
+        } else if (*p == '^' && u == ue) {
+            ++p;
+            continue;
+        } else if (u < ue && (*p == '^' ? isSeparator(*u) : *p == *u)) {
+            ++p;
+            ++u;
+            continue;
+        }
+        if (!starP || starU == ue) return false;
+        p = starP;
+        u = ++starU;
+    }
+}
+
+static quint32 tokenHash(const char *b, const char *e) {
+    return quint32(qHash(QByteArrayView(b, e - b)));
+}
+
+void FilterMatcher::addList(const QByteArray &text) {
+    for (const QByteArray &raw : text.split('\n')) addRule(raw.trimmed());
+}
+
+void FilterMatcher::addRule(const QByteArray &input) {
+    if (input.isEmpty() || input.startsWith('!') || input.startsWith('[')) return;
+    // Cosmetic filters need a content script, not the network path.
+    if (input.contains("##") || input.contains("#@#") || input.contains("#?#")) return;
+
+    QByteArray line = input.toLower();
+    Rule rule;
+    if (line.startsWith("@@")) {
+        rule.exception = true;
+        line = line.mid(2);
+    }
+
+    const int dollar = line.lastIndexOf('$');
+    if (dollar != -1) {
+        for (const QByteArray &opt : line.mid(dollar + 1).split(',')) {
+            if (opt == "third-party") rule.thirdPartyOnly = true;
+            else if (opt == "~third-party") rule.firstPartyOnly = true;
+            else if (opt == "match-case") continue;
+            else if (opt == "script") rule.types |= Script;
+            else if (opt == "image") rule.types |= Image;
+            else if (opt == "stylesheet") rule.types |= Stylesheet;
+            else if (opt == "subdocument") rule.types |= Subdocument;
+            else if (opt == "xmlhttprequest") rule.types |= XmlHttpRequest;
+            else if (opt == "media") rule.types |= Media;
+            else if (opt == "font") rule.types |= Font;
+            else if (opt == "object") rule.types |= Object;
+            else if (opt == "ping") rule.types |= Ping;
+            else if (opt == "other") rule.types |= Other;
+            // domain=, csp=, redirect= and friends narrow a rule in ways we
+            // cannot honour here; dropping it beats over-blocking.
+            else return;
+        }
+        line.truncate(dollar);
+    }
+
+    if (line.startsWith("||")) {
+        rule.hostAnchor = true;
+        line = line.mid(2);
+    } else if (line.startsWith('|')) {
+        rule.startAnchor = true;
+        line = line.mid(1);
+    }
+    if (line.endsWith('|')) {
+        rule.endAnchor = true;
+        line.chop(1);
+    }
+    if (line.isEmpty() || line == "*") return;
+    rule.pattern = line;
+
+    const int id = rules.size();
+    rules.append(rule);
+
+    // Plain "||example.com^" rules go into the domain table.
+    if (rule.hostAnchor && !rule.endAnchor) {
+        QByteArray domain = line;
+        if (domain.endsWith('^')) domain.chop(1);
+        bool plain = !domain.isEmpty();
+        for (char c : std::as_const(domain)) {
+            if (!isTokenChar(c) && c != '.' && c != '-') { plain = false; break; }
+        }
+        if (plain) {
+            const quint32 h = tokenHash(domain.constData(), domain.constData() + domain.size());
+            (rule.exception ? allowedDomains : blockedDomains)[h].append(id);
+            return;
+        }
+    }
+
+    // Index under the rarest complete token; tokens touching '*' may be partial.
+    const char *b = line.constData();
+    const char *e = b + line.size();
+    int best = -1;
+    quint32 bestHash = 0;
+    for (const char *p = b; p < e;) {
+        if (!isTokenChar(*p)) { ++p; continue; }
+        const char *start = p;
+        while (p < e && isTokenChar(*p)) ++p;
+        const bool partial = (start > b && start[-1] == '*') || (p < e && *p == '*')
+                          || (start == b && !rule.hostAnchor && !rule.startAnchor)
+                          || (p == e && !rule.endAnchor);
+        if (partial || p - start < 3) continue;
+        const quint32 h = tokenHash(start, p);
+        const int load = tokenRules.value(h).size();
+        if (best == -1 || load < best) {
+            best = load;
+            bestHash = h;
+        }
+    }
+    if (best == -1) untokenized.append(id);
+    else tokenRules[bestHash].append(id);
+}
+
+// Rules filed under the host or any of its parent domains; several rules may
+// share a domain, each with its own options.
+QVector<int> FilterMatcher::domainRules(const QHash<quint32, QVector<int>> &domains, const QByteArray &host) {
+    QVector<int> ids;
+    if (domains.isEmpty()) return ids;
+    int from = 0;
+    while (from < host.size()) {
+        auto it = domains.constFind(tokenHash(host.constData() + from, host.constData() + host.size()));
+        if (it != domains.constEnd()) ids += it.value();
+        const int dot = host.indexOf('.', from);
+        if (dot == -1) break;
+        from = dot + 1;
+    }
+    return ids;
+}
+
+bool FilterMatcher::ruleMatches(const Rule &rule, const QByteArray &url, bool thirdParty, quint32 type) const {
+    if (rule.thirdPartyOnly && !thirdParty) return false;
+    if (rule.firstPartyOnly && thirdParty) return false;
+    if (rule.types && !(rule.types & type)) return false;
+
+    const char *p = rule.pattern.constData();
+    const char *pe = p + rule.pattern.size();
+    const char *u = url.constData();
+    const char *ue = u + url.size();
+
+    if (rule.startAnchor) return matchAt(p, pe, u, ue, rule.endAnchor);
+
+    if (rule.hostAnchor) {
+        const int scheme = url.indexOf("://");
+        if (scheme == -1) return false;
+        const char *host = u + scheme + 3;
+        const char *hostEnd = host;
+        while (hostEnd < ue && *hostEnd != '/' && *hostEnd != ':' && *hostEnd != '?') ++hostEnd;
+        for (const char *s = host; s < hostEnd; ++s) {
+            if ((s == host || s[-1] == '.') && matchAt(p, pe, s, ue, rule.endAnchor)) return true;
+        }
+        return false;
+    }
+
+    for (const char *s = u; s < ue; ++s) {
+        if (*p != '*' && *p != '^' && *p != *s) continue;
+        if (matchAt(p, pe, s, ue, rule.endAnchor)) return true;
+    }
+    return false;
+}
+
+FilterMatcher::Decision FilterMatcher::match(const QByteArray &url, const QByteArray &host, bool thirdParty, quint32 type) const {
+    bool block = false;
+    bool allow = false;
+
+    auto check = [&](int id) {
+        const Rule &rule = rules.at(id);
+        if (rule.exception ? allow : block) return;
+        if (!ruleMatches(rule, url, thirdParty, type)) return;
+        if (rule.exception) allow = true;
+        else block = true;
+    };
+
+    for (int id : domainRules(blockedDomains, host)) check(id);
+    for (int id : domainRules(allowedDomains, host)) check(id);
+
+    const char *b = url.constData();
+    const char *e = b + url.size();
+    for (const char *p = b; p < e && !allow;) {
+        if (!isTokenChar(*p)) { ++p; continue; }
+        const char *start = p;
+        while (p < e && isTokenChar(*p)) ++p;
+        if (p - start < 3) continue;
+        auto it = tokenRules.constFind(tokenHash(start, p));
+        if (it == tokenRules.constEnd()) continue;
+        for (int id : it.value()) check(id);
+    }
+    for (int id : untokenized) check(id);
+
+    if (!block) return NoMatch;
+    return allow ? Allow : Block;
+}
+
+static quint32 requestType(QWebEngineUrlRequestInfo::ResourceType type) {
+    switch (type) {
+    case QWebEngineUrlRequestInfo::ResourceTypeScript:
+    case QWebEngineUrlRequestInfo::ResourceTypeWorker:
+    case QWebEngineUrlRequestInfo::ResourceTypeSharedWorker:
+    case QWebEngineUrlRequestInfo::ResourceTypeServiceWorker:
+        return FilterMatcher::Script;
+    case QWebEngineUrlRequestInfo::ResourceTypeImage:
+    case QWebEngineUrlRequestInfo::ResourceTypeFavicon:
+        return FilterMatcher::Image;
+    case QWebEngineUrlRequestInfo::ResourceTypeStylesheet:
+        return FilterMatcher::Stylesheet;
+    case QWebEngineUrlRequestInfo::ResourceTypeSubFrame:
+        return FilterMatcher::Subdocument;
+    case QWebEngineUrlRequestInfo::ResourceTypeXhr:
+        return FilterMatcher::XmlHttpRequest;
+    case QWebEngineUrlRequestInfo::ResourceTypeMedia:
+        return FilterMatcher::Media;
+    case QWebEngineUrlRequestInfo::ResourceTypeFontResource:
+        return FilterMatcher::Font;
+    case QWebEngineUrlRequestInfo::ResourceTypeObject:
+    case QWebEngineUrlRequestInfo::ResourceTypePluginResource:
+        return FilterMatcher::Object;
+    case QWebEngineUrlRequestInfo::ResourceTypePing:
+    case QWebEngineUrlRequestInfo::ResourceTypeCspReport:
+        return FilterMatcher::Ping;
+    default:
+        return FilterMatcher::Other;
+    }
+}
+
+// Registrable domain approximated by the last two labels; good enough to tell
+// cdn.example.com apart from tracker.net without shipping the public suffix list.
+QByteArray ContentBlocker::siteOf(const QByteArray &host) {
+    const int last = host.lastIndexOf('.');
+    if (last <= 0) return host;
+    const int prev = host.lastIndexOf('.', last - 1);
+    return host.mid(prev + 1);
+}
+
+ContentBlocker::ContentBlocker(const QString &filterDir, QObject *parent)
+    : QWebEngineUrlRequestInterceptor(parent), filterDir(filterDir) {
+    reload();
+}
+
+ContentBlocker::~ContentBlocker() {
+    QThreadPool::globalInstance()->waitForDone();
+}
+
+void ContentBlocker::loadDir(FilterMatcher &m, const QString &dir) {
+    const QStringList files = QDir(dir).entryList({"*.txt"}, QDir::Files, QDir::Name);
+    for (const QString &name : files) {
+        QFile f(dir + "/" + name);
+        if (f.open(QIODevice::ReadOnly)) m.addList(f.readAll());
+    }
+}
+
+void ContentBlocker::setStrict(bool on) {
+    if (strict == on) return;
+    strict = on;
+    reload();
+}
+
+// Builds can finish out of order when the level is switched quickly; only
+// the one started last may replace the matcher.
+void ContentBlocker::reload() {
+    const QString dir = filterDir;
+    const bool withStrict = strict;
+    const int build = ++generation;
+    QThreadPool::globalInstance()->start([this, dir, withStrict, build]() {
+        auto m = std::make_shared<FilterMatcher>();
+        loadDir(*m, dir);
+        if (withStrict) loadDir(*m, dir + "/strict");
+        QMutexLocker lock(&swapLock);
+        if (build == generation.load()) std::atomic_store(&matcher, std::shared_ptr<const FilterMatcher>(m));
+    });
+}
+
+void ContentBlocker::interceptRequest(QWebEngineUrlRequestInfo &info) {
+    if (!filter(info) && next) next->interceptRequest(info);
+}
+
+bool ContentBlocker::filter(QWebEngineUrlRequestInfo &info) {
+    // Top-level navigations are the user's choice, never a subresource to filter.
+    if (!enabled.load() || info.resourceType() == QWebEngineUrlRequestInfo::ResourceTypeMainFrame) return false;
+    std::shared_ptr<const FilterMatcher> m = std::atomic_load(&matcher);
+    if (!m || m->ruleCount() == 0) return false;
+
+    const QUrl url = info.requestUrl();
+    const QByteArray host = url.host(QUrl::FullyEncoded).toLatin1();
+    const QByteArray firstParty = info.firstPartyUrl().host(QUrl::FullyEncoded).toLatin1();
+    const bool thirdParty = siteOf(host) != siteOf(firstParty);
+
+    if (m->match(url.toEncoded().toLower(), host, thirdParty, requestType(info.resourceType())) != FilterMatcher::Block) return false;
+    info.block(true);
+    blocked++;
+    return true;
+}
@@ -0,0 +1,91 @@
+#ifndef CONTENTBLOCKER_H
+#define CONTENTBLOCKER_H
+
+#include <QWebEngineUrlRequestInterceptor>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+#include <atomic>
+
+// Network rules compiled from EasyList/ABP-format filter lists. "||domain^"
+// anchors become a hashed domain set matched by walking a host's labels;
+// every other pattern is indexed under its rarest token, so a request only
+// checks the handful of rules that share a token with its URL.
+class FilterMatcher {
+public:
+    enum Decision { NoMatch, Block, Allow };
+    enum Type : quint32 {
+        Script = 1, Image = 2, Stylesheet = 4, Subdocument = 8, XmlHttpRequest = 16,
+        Media = 32, Font = 64, Object = 128, Ping = 256, Other = 512
+    };
+
+    void addList(const QByteArray &text);
+    Decision match(const QByteArray &url, const QByteArray &host, bool thirdParty, quint32 type) const;
+    int ruleCount() const { return rules.size(); }
+
+private:
+    struct Rule {
+        QByteArray pattern;
+        bool exception = false;
+        bool thirdPartyOnly = false;
+        bool firstPartyOnly = false;
+        bool hostAnchor = false;
+        bool startAnchor = false;
+        bool endAnchor = false;
+        quint32 types = 0;
+    };
+
+    QVector<Rule> rules;
+    QHash<quint32, QVector<int>> tokenRules;
+    QVector<int> untokenized;
+    QHash<quint32, QVector<int>> blockedDomains;
+    QHash<quint32, QVector<int>> allowedDomains;
+
+    void addRule(const QByteArray &line);
+    bool ruleMatches(const Rule &rule, const QByteArray &url, bool thirdParty, quint32 type) const;
+    static QVector<int> domainRules(const QHash<quint32, QVector<int>> &domains, const QByteArray &host);
+};
+
+// Request interceptor that asks a FilterMatcher about every subresource.
+// Lists are read from user_data/filters/ (and filters/strict/ for the
+// "Hardest" privacy level); the compiled matcher is swapped in atomically so
+// the IO thread never waits on a reload. A profile takes only one interceptor,
+// so anything else that filters requests is chained behind this one and sees
+// whatever the lists let through.
+class ContentBlocker : public QWebEngineUrlRequestInterceptor {
+    Q_OBJECT
+public:
+    explicit ContentBlocker(const QString &filterDir, QObject *parent = nullptr);
+
+    void interceptRequest(QWebEngineUrlRequestInfo &info) override;
+    ~ContentBlocker();
+
+    void setEnabled(bool on) { enabled.store(on); }
+    // Set once, before the profile loads anything.
+    void setNext(QWebEngineUrlRequestInterceptor *interceptor) { next = interceptor; }
+    void setStrict(bool strict);
+    void reload();
+    bool isStrict() const { return strict; }
+    qint64 blockedCount() const { return blocked.load(); }
+
+    static QByteArray siteOf(const QByteArray &host);
+
+private:
+    QString filterDir;
+    bool strict = false;
+    std::atomic_bool enabled{true};
+    std::shared_ptr<const FilterMatcher> matcher;
+    std::atomic<qint64> blocked{0};
+    std::atomic_int generation{0};
+    QMutex swapLock;
+    QWebEngineUrlRequestInterceptor *next = nullptr;
+
+    bool filter(QWebEngineUrlRequestInfo &info);
+    static void loadDir(FilterMatcher &m, const QString &dir);
+};
+
+#endif
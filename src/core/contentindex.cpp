@@ -0,0 +1,585 @@
+#include "contentindex.h"
+#include "historystore.h"
+#include "omnibox.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QSaveFile>
+#include <QSet>
+#include <QVector>
+#include <QWebEnginePage>
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+static const quint32 SegmentMagic = 0x43494458;   // "CIDX"
+static const quint32 JournalMagic = 0x4349444a;   // "CIDJ"
+static const quint32 IndexVersion = 1;
+static const int MaxTextChars = 1 << 20;
+static const int MaxTokens = 20000;
+static const int MaxPrefixTerms = 64;
+static const int MaxResults = 100;
+static const qint64 JournalLimit = 8ll << 20;
+
+enum JournalRecord : quint8 { AddRecord = 1, RemoveRecord = 2, TouchRecord = 3 };
+
+// Postings are (doc id delta, term frequency) pairs, both as LEB128 varints.
+static void putVarint(QByteArray &out, quint32 v) {
+    while (v >= 0x80) {
+        out.append(char(v | 0x80));
+        v >>= 7;
+    }
+    out.append(char(v));
+}
+
+static quint32 getVarint(const char *&p) {
+    quint32 v = 0;
+    for (int shift = 0;; shift += 7) {
+        const quint8 b = quint8(*p++);
+        v |= quint32(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+}
+
+struct ContentDoc {
+    QString url;
+    QString title;
+    qint64 lastVisit = 0;
+    quint32 length = 0;
+    qint64 textOffset = 0;
+    quint32 textSize = 0;
+    quint32 bytes = 0;
+    quint32 textHash = 0;
+    bool alive = false;
+};
+
+static QDataStream &operator<<(QDataStream &out, const ContentDoc &d) {
+    return out << d.url << d.title << d.lastVisit << d.length << d.textOffset << d.textSize << d.bytes << d.textHash << d.alive;
+}
+
+static QDataStream &operator>>(QDataStream &in, ContentDoc &d) {
+    return in >> d.url >> d.title >> d.lastVisit >> d.length >> d.textOffset >> d.textSize >> d.bytes >> d.textHash >> d.alive;
+}
+
+struct Posting {
+    QByteArray data;
+    quint32 last = 0;
+    quint32 df = 0;
+};
+
+// Owns every byte of index state and lives on ContentIndex's thread; the GUI
+// side only ever posts work to it.
+class ContentIndexWorker : public QObject {
+public:
+    ContentIndexWorker(const QString &dir, ContentIndex *owner) : dir(dir), owner(owner) {}
+
+    qint64 budget = 256ll << 20;
+
+    void open();
+    void add(const QString &url, const QString &title, const QString &text, qint64 when);
+    QString search(const QString &query, int max);
+    void clear();
+    ContentIndex *client() const { return owner; }
+
+private:
+    QString dir;
+    ContentIndex *owner;
+    QVector<ContentDoc> docs;
+    QHash<QString, int> byUrl;
+    std::map<QString, Posting> terms;
+    QHash<int, QByteArray> memoryText;
+    int live = 0;
+    int dead = 0;
+    qint64 liveBytes = 0;
+    qint64 totalLength = 0;
+    quint32 generation = 0;
+    QFile journal;
+    QFile text;
+
+    bool persistent() const { return !dir.isEmpty(); }
+    QString textPath(quint32 gen) const { return dir + QString("/text-%1.dat").arg(gen); }
+    void insert(const ContentDoc &doc, const QHash<QString, quint16> &tf);
+    void remove(int id, bool logged);
+    void touch(int id, qint64 when, bool logged);
+    void prune();
+    void maybeCompact();
+    void compact();
+    void startJournal();
+    void replayJournal();
+    QByteArray readText(int id);
+    QString snippet(int id, const QStringList &words);
+};
+
+void ContentIndexWorker::open() {
+    if (!persistent()) return;
+    QDir().mkpath(dir);
+
+    QFile segment(dir + "/segment.bin");
+    if (segment.open(QIODevice::ReadOnly)) {
+        QDataStream in(&segment);
+        in.setVersion(QDataStream::Qt_6_0);
+        quint32 magic = 0, version = 0, count = 0;
+        in >> magic >> version;
+        if (magic == SegmentMagic && version == IndexVersion) {
+            in >> generation >> docs >> count;
+            for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+                QString term;
+                Posting p;
+                in >> term >> p.last >> p.df >> p.data;
+                terms.emplace(term, p);
+            }
+        }
+        if (in.status() != QDataStream::Ok) {
+            docs.clear();
+            terms.clear();
+            generation = 0;
+        }
+    }
+    for (int id = 0; id < docs.size(); ++id) {
+        const ContentDoc &d = docs.at(id);
+        if (!d.alive) continue;
+        byUrl.insert(HistoryStore::normalize(QUrl(d.url)), id);
+        live++;
+        liveBytes += d.bytes;
+        totalLength += d.length;
+    }
+
+    text.setFileName(textPath(generation));
+    text.open(QIODevice::ReadWrite);
+    replayJournal();
+}
+
+// The journal names the segment generation it extends, so one left over from
+// before a compaction is recognised and dropped instead of replayed.
+void ContentIndexWorker::startJournal() {
+    journal.close();
+    journal.setFileName(dir + "/journal.bin");
+    if (!journal.open(QIODevice::WriteOnly | QIODevice::Truncate)) return;
+    QDataStream out(&journal);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << JournalMagic << IndexVersion << generation;
+    journal.flush();
+}
+
+void ContentIndexWorker::replayJournal() {
+    journal.setFileName(dir + "/journal.bin");
+    if (!journal.open(QIODevice::ReadWrite)) return;
+    QDataStream in(&journal);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0, version = 0, gen = 0;
+    in >> magic >> version >> gen;
+    if (in.status() != QDataStream::Ok || magic != JournalMagic || version != IndexVersion || gen != generation) {
+        startJournal();
+        return;
+    }
+
+    // Records are applied one by one; a torn last record is cut off so new
+    // ones are appended after the last complete one.
+    qint64 good = journal.pos();
+    while (!in.atEnd()) {
+        quint8 type = 0;
+        qint32 id = -1;
+        in >> type >> id;
+        if (type == AddRecord) {
+            ContentDoc doc;
+            QHash<QString, quint16> tf;
+            in >> doc >> tf;
+            if (in.status() != QDataStream::Ok || id != docs.size()) break;
+            insert(doc, tf);
+        } else if (type == RemoveRecord) {
+            if (in.status() != QDataStream::Ok) break;
+            remove(id, false);
+        } else if (type == TouchRecord) {
+            qint64 when = 0;
+            in >> when;
+            if (in.status() != QDataStream::Ok) break;
+            touch(id, when, false);
+        } else {
+            break;
+        }
+        good = journal.pos();
+    }
+    journal.resize(good);
+    journal.seek(good);
+}
+
+void ContentIndexWorker::insert(const ContentDoc &doc, const QHash<QString, quint16> &tf) {
+    const quint32 id = docs.size();
+    docs.append(doc);
+    if (!doc.alive) {
+        dead++;
+        return;
+    }
+    byUrl.insert(HistoryStore::normalize(QUrl(doc.url)), id);
+    live++;
+    liveBytes += doc.bytes;
+    totalLength += doc.length;
+
+    for (auto it = tf.cbegin(); it != tf.cend(); ++it) {
+        Posting &p = terms[it.key()];
+        putVarint(p.data, p.df ? id - p.last : id);
+        putVarint(p.data, it.value());
+        p.last = id;
+        p.df++;
+    }
+}
+
+void ContentIndexWorker::remove(int id, bool logged) {
+    if (id < 0 || id >= docs.size() || !docs.at(id).alive) return;
+    ContentDoc &d = docs[id];
+    d.alive = false;
+    live--;
+    dead++;
+    liveBytes -= d.bytes;
+    totalLength -= d.length;
+    const QString key = HistoryStore::normalize(QUrl(d.url));
+    if (byUrl.value(key, -1) == id) byUrl.remove(key);
+    memoryText.remove(id);
+
+    if (logged && journal.isOpen()) {
+        QDataStream out(&journal);
+        out.setVersion(QDataStream::Qt_6_0);
+        out << quint8(RemoveRecord) << qint32(id);
+        journal.flush();
+    }
+}
+
+void ContentIndexWorker::touch(int id, qint64 when, bool logged) {
+    if (id < 0 || id >= docs.size()) return;
+    docs[id].lastVisit = when;
+    if (logged && journal.isOpen()) {
+        QDataStream out(&journal);
+        out.setVersion(QDataStream::Qt_6_0);
+        out << quint8(TouchRecord) << qint32(id) << when;
+        journal.flush();
+    }
+}
+
+void ContentIndexWorker::add(const QString &url, const QString &title, const QString &pageText, qint64 when) {
+    const QString body = pageText.left(MaxTextChars);
+    const quint32 hash = qHash(body);
+    const int existing = byUrl.value(HistoryStore::normalize(QUrl(url)), -1);
+    if (existing != -1) {
+        // A revisit of an unchanged page only counts as recent use.
+        if (docs.at(existing).textHash == hash) {
+            touch(existing, when, true);
+            return;
+        }
+        remove(existing, true);
+    }
+
+    QHash<QString, quint16> tf;
+    quint32 length = 0;
+    const QStringList words = SuggestionIndex::tokenize(title + ' ' + body);
+    for (const QString &w : words) {
+        if (w.size() < 2 || w.size() > 40) continue;
+        quint16 &n = tf[w];
+        if (n < 0xffff) n++;
+        if (++length >= MaxTokens) break;
+    }
+    if (tf.isEmpty()) return;
+
+    const QByteArray blob = qCompress(body.toUtf8());
+    ContentDoc doc;
+    doc.url = url;
+    doc.title = title;
+    doc.lastVisit = when;
+    doc.length = length;
+    doc.textSize = blob.size();
+    doc.textHash = hash;
+    doc.alive = true;
+    doc.bytes = blob.size() + 4 * tf.size() + 2 * (url.size() + title.size()) + 64;
+
+    const int id = docs.size();
+    if (persistent()) {
+        doc.textOffset = text.size();
+        text.seek(doc.textOffset);
+        text.write(blob);
+        text.flush();
+    } else {
+        memoryText.insert(id, blob);
+    }
+    insert(doc, tf);
+
+    if (journal.isOpen()) {
+        QDataStream out(&journal);
+        out.setVersion(QDataStream::Qt_6_0);
+        out << quint8(AddRecord) << qint32(id) << doc << tf;
+        journal.flush();
+    }
+
+    if (liveBytes > budget) prune();
+    maybeCompact();
+}
+
+// Least recently visited pages go first, down to 90% of the budget so that
+// pruning does not run again on the very next page.
+void ContentIndexWorker::prune() {
+    QVector<int> ids;
+    for (int id = 0; id < docs.size(); ++id) {
+        if (docs.at(id).alive) ids.append(id);
+    }
+    std::sort(ids.begin(), ids.end(), [this](int a, int b) { return docs.at(a).lastVisit < docs.at(b).lastVisit; });
+    const qint64 target = budget * 9 / 10;
+    for (int id : std::as_const(ids)) {
+        if (liveBytes <= target) break;
+        remove(id, true);
+    }
+}
+
+void ContentIndexWorker::maybeCompact() {
+    if ((dead > 1000 && dead > live / 4) || (persistent() && journal.size() > JournalLimit)) compact();
+}
+
+// Drops removed pages for good: live documents are renumbered densely (which
+// keeps every posting list in increasing order), their text is copied into a
+// new text file, and the whole index is written out as the next segment.
+// Nothing changes in memory unless the new segment made it to disk.
+void ContentIndexWorker::compact() {
+    QVector<int> remap(docs.size(), -1);
+    QVector<ContentDoc> kept;
+    QHash<int, QByteArray> keptText;
+    QFile next;
+    if (persistent()) {
+        next.setFileName(textPath(generation + 1));
+        if (!next.open(QIODevice::WriteOnly | QIODevice::Truncate)) return;
+    }
+    for (int id = 0; id < docs.size(); ++id) {
+        if (!docs.at(id).alive) continue;
+        ContentDoc d = docs.at(id);
+        const QByteArray blob = readText(id);
+        if (persistent()) {
+            d.textOffset = next.pos();
+            next.write(blob);
+        } else {
+            keptText.insert(kept.size(), blob);
+        }
+        remap[id] = kept.size();
+        kept.append(d);
+    }
+
+    std::map<QString, Posting> packed;
+    for (const auto &[term, p] : terms) {
+        Posting rebuilt;
+        const char *c = p.data.constData();
+        const char *end = c + p.data.size();
+        quint32 id = 0;
+        for (quint32 i = 0; c < end; ++i) {
+            id = i ? id + getVarint(c) : getVarint(c);
+            const quint32 freq = getVarint(c);
+            const int to = remap.value(id, -1);
+            if (to < 0) continue;
+            putVarint(rebuilt.data, rebuilt.df ? to - rebuilt.last : to);
+            putVarint(rebuilt.data, freq);
+            rebuilt.last = to;
+            rebuilt.df++;
+        }
+        if (rebuilt.df) packed.emplace_hint(packed.end(), term, rebuilt);
+    }
+
+    if (persistent()) {
+        next.close();
+        QSaveFile segment(dir + "/segment.bin");
+        bool written = segment.open(QIODevice::WriteOnly) && next.error() == QFileDevice::NoError;
+        if (written) {
+            QDataStream out(&segment);
+            out.setVersion(QDataStream::Qt_6_0);
+            out << SegmentMagic << IndexVersion << (generation + 1) << kept << quint32(packed.size());
+            for (const auto &[term, p] : packed) out << term << p.last << p.df << p.data;
+            written = segment.commit();
+        }
+        if (!written) {
+            // The journal still describes what is on disk; try again later.
+            QFile::remove(next.fileName());
+            return;
+        }
+        text.close();
+        QFile::remove(textPath(generation));
+        generation++;
+        text.setFileName(textPath(generation));
+        text.open(QIODevice::ReadWrite);
+        startJournal();
+    }
+
+    docs = kept;
+    terms = std::move(packed);
+    memoryText = keptText;
+    dead = 0;
+    byUrl.clear();
+    for (int id = 0; id < docs.size(); ++id) byUrl.insert(HistoryStore::normalize(QUrl(docs.at(id).url)), id);
+}
+
+QByteArray ContentIndexWorker::readText(int id) {
+    if (!persistent()) return memoryText.value(id);
+    const ContentDoc &d = docs.at(id);
+    if (!text.seek(d.textOffset)) return QByteArray();
+    return text.read(d.textSize);
+}
+
+QString ContentIndexWorker::snippet(int id, const QStringList &words) {
+    const QString body = QString::fromUtf8(qUncompress(readText(id)));
+    int at = -1;
+    int matched = 0;
+    for (const QString &w : words) {
+        const int i = body.indexOf(w, 0, Qt::CaseInsensitive);
+        if (i != -1 && (at == -1 || i < at)) {
+            at = i;
+            matched = w.size();
+        }
+    }
+    if (at == -1) return body.left(160).simplified();
+    const int start = qMax(0, at - 80);
+    return (start > 0 ? "..." : "") + body.mid(start, 160 + matched).simplified() + "...";
+}
+
+QString ContentIndexWorker::search(const QString &query, int max) {
+    QStringList words;
+    for (const QString &w : SuggestionIndex::tokenize(query)) {
+        if (!words.contains(w)) words.append(w);
+    }
+    if (words.isEmpty() || live == 0) return "[]";
+    max = qBound(1, max, MaxResults);
+
+    // Every word must match; the last one also matches as a prefix, since it
+    // is usually still being typed.
+    struct Word { QList<const Posting*> lists; quint64 df = 0; };
+    QVector<Word> matched;
+    for (int i = 0; i < words.size(); ++i) {
+        Word word;
+        if (i == words.size() - 1) {
+            for (auto it = terms.lower_bound(words[i]);
+                 it != terms.end() && it->first.startsWith(words[i]) && word.lists.size() < MaxPrefixTerms; ++it) {
+                word.lists.append(&it->second);
+                word.df += it->second.df;
+            }
+        } else {
+            auto it = terms.find(words[i]);
+            if (it != terms.end()) {
+                word.lists.append(&it->second);
+                word.df = it->second.df;
+            }
+        }
+        if (word.lists.isEmpty()) return "[]";
+        matched.append(word);
+    }
+    std::sort(matched.begin(), matched.end(), [](const Word &a, const Word &b) { return a.df < b.df; });
+
+    // BM25 over the surviving candidates, rarest word first so that every
+    // later list only has to be checked against a small set.
+    const double k1 = 1.2, b = 0.75;
+    const double avgLength = double(totalLength) / live;
+    QHash<quint32, double> scores;
+    for (int w = 0; w < matched.size(); ++w) {
+        QHash<quint32, double> hits;
+        for (const Posting *p : std::as_const(matched[w].lists)) {
+            const double idf = std::log(1 + (live - p->df + 0.5) / (p->df + 0.5));
+            const char *c = p->data.constData();
+            const char *end = c + p->data.size();
+            quint32 id = 0;
+            for (quint32 i = 0; c < end; ++i) {
+                id = i ? id + getVarint(c) : getVarint(c);
+                const double tf = getVarint(c);
+                const ContentDoc &d = docs.at(id);
+                if (!d.alive || (w > 0 && !scores.contains(id))) continue;
+                hits[id] += idf * tf * (k1 + 1) / (tf + k1 * (1 - b + b * d.length / avgLength));
+            }
+        }
+        if (w == 0) {
+            scores = hits;
+        } else {
+            QHash<quint32, double> both;
+            for (auto it = hits.cbegin(); it != hits.cend(); ++it) both.insert(it.key(), scores.value(it.key()) + it.value());
+            scores = both;
+        }
+        if (scores.isEmpty()) return "[]";
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QVector<QPair<double, quint32>> ranked;
+    ranked.reserve(scores.size());
+    for (auto it = scores.cbegin(); it != scores.cend(); ++it) {
+        const double ageDays = double(now - docs.at(it.key()).lastVisit) / 86400000.0;
+        ranked.append({it.value() * (1 + 0.3 / (1 + ageDays / 7)), it.key()});
+    }
+    const int n = qMin(max, int(ranked.size()));
+    std::partial_sort(ranked.begin(), ranked.begin() + n, ranked.end(),
+                      [](const QPair<double, quint32> &x, const QPair<double, quint32> &y) { return x.first > y.first; });
+
+    QJsonArray array;
+    for (int i = 0; i < n; ++i) {
+        const ContentDoc &d = docs.at(ranked.at(i).second);
+        array.append(QJsonObject{{"url", d.url}, {"title", d.title}, {"snippet", snippet(ranked.at(i).second, words)},
+                                 {"score", ranked.at(i).first}, {"lastVisit", d.lastVisit}});
+    }
+    return QString::fromUtf8(QJsonDocument(array).toJson(QJsonDocument::Compact));
+}
+
+void ContentIndexWorker::clear() {
+    docs.clear();
+    byUrl.clear();
+    terms.clear();
+    memoryText.clear();
+    live = dead = 0;
+    liveBytes = totalLength = 0;
+    if (!persistent()) return;
+
+    text.close();
+    QFile::remove(textPath(generation));
+    QFile::remove(dir + "/segment.bin");
+    generation = 0;
+    text.setFileName(textPath(generation));
+    text.open(QIODevice::ReadWrite | QIODevice::Truncate);
+    startJournal();
+}
+
+ContentIndex::ContentIndex(const QString &dir, QObject *parent)
+    : QObject(parent), worker(new ContentIndexWorker(dir, this)) {
+    worker->moveToThread(&thread);
+    connect(&thread, &QThread::finished, worker, &QObject::deleteLater);
+    thread.setObjectName("ContentIndex");
+    thread.start(QThread::LowPriority);
+    QMetaObject::invokeMethod(worker, [w = worker]() { w->open(); }, Qt::QueuedConnection);
+}
+
+ContentIndex::~ContentIndex() {
+    thread.quit();
+    thread.wait();
+}
+
+void ContentIndex::setBudget(qint64 bytes) {
+    QMetaObject::invokeMethod(worker, [w = worker, bytes]() { w->budget = bytes; }, Qt::QueuedConnection);
+}
+
+// Only the text extraction touches the GUI thread, and that is an async call
+// into the renderer; tokenizing, compressing and writing all happen on the worker.
+void ContentIndex::index(QWebEnginePage *page) {
+    const QUrl url = page->url();
+    if (url.scheme() != "http" && url.scheme() != "https") return;
+    const QString title = page->title();
+    const qint64 when = QDateTime::currentMSecsSinceEpoch();
+    QPointer<ContentIndex> self(this);
+    page->toPlainText([self, url, title, when](const QString &text) {
+        if (!self || text.trimmed().isEmpty()) return;
+        ContentIndexWorker *w = self->worker;
+        QMetaObject::invokeMethod(w, [w, url, title, text, when]() { w->add(url.toString(), title, text, when); },
+                                  Qt::QueuedConnection);
+    });
+}
+
+void ContentIndex::search(const QString &text, int max) {
+    QMetaObject::invokeMethod(worker, [w = worker, text, max]() {
+        const QString json = w->search(text, max);
+        ContentIndex *owner = w->client();
+        QMetaObject::invokeMethod(owner, [owner, text, json]() { emit owner->results(text, json); }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void ContentIndex::clear() {
+    QMetaObject::invokeMethod(worker, [w = worker]() { w->clear(); }, Qt::QueuedConnection);
+}
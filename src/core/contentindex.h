@@ -0,0 +1,39 @@
+#ifndef CONTENTINDEX_H
+#define CONTENTINDEX_H
+
+#include <QObject>
+#include <QThread>
+
+class QWebEnginePage;
+class ContentIndexWorker;
+
+// Full-text index over the text of visited pages, so history can be searched
+// by what a page said and not just its URL or title. Page text is pulled once
+// a load finishes and handed to a dedicated worker thread, which tokenizes and
+// compresses it and appends it to an on-disk inverted index (delta-encoded
+// posting lists, a journal of recent additions and a periodically rewritten
+// segment). The index stays within a size budget by dropping the least
+// recently visited pages. Searches run on the same worker and answer through
+// results(), ranked by BM25 with a small recency boost.
+class ContentIndex : public QObject {
+    Q_OBJECT
+public:
+    explicit ContentIndex(const QString &dir, QObject *parent = nullptr);
+    ~ContentIndex();
+
+    void setBudget(qint64 bytes);
+    void index(QWebEnginePage *page);
+
+    Q_INVOKABLE void search(const QString &text, int max);
+    Q_INVOKABLE void clear();
+
+signals:
+    // JSON array of {url, title, snippet, score, lastVisit}, best first.
+    void results(const QString &query, const QString &json);
+
+private:
+    QThread thread;
+    ContentIndexWorker *worker;
+};
+
+#endif
@@ -0,0 +1,355 @@
+#include "controlserver.h"
+#include "browser.h"
+#include "historystore.h"
+#include "omnibox.h"
+#include "perftrace.h"
+#include "tablifecycle.h"
+#include <QApplication>
+#include <QBuffer>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocalSocket>
+#include <QPointer>
+#include <QTimer>
+#include <memory>
+
+ControlServer::ControlServer(const QString &name, QObject *parent) : QObject(parent), name(name) {
+    methods.insert("tabs.list", &ControlServer::listTabs);
+    methods.insert("tabs.open", &ControlServer::openTab);
+    methods.insert("tabs.close", &ControlServer::closeTab);
+    methods.insert("tabs.navigate", &ControlServer::navigateTab);
+    methods.insert("tabs.waitForLoad", &ControlServer::waitForLoad);
+    methods.insert("tabs.evaluate", &ControlServer::evaluate);
+    methods.insert("tabs.screenshot", &ControlServer::screenshot);
+    methods.insert("history.query", &ControlServer::queryHistory);
+    methods.insert("metrics.get", &ControlServer::metrics);
+
+    connect(&server, &QLocalServer::newConnection, this, [this]() {
+        while (QLocalSocket *socket = server.nextPendingConnection()) {
+            connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+            connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+                while (socket->canReadLine()) {
+                    const QByteArray line = socket->readLine().trimmed();
+                    if (!line.isEmpty()) handleLine(socket, line);
+                }
+            });
+        }
+    });
+}
+
+bool ControlServer::start() {
+    // Another instance answering on the name keeps it. Only a socket file left
+    // behind by a crashed one, which would block listen(), is removed.
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(500)) {
+        qWarning("Control socket %s is in use by another instance", qPrintable(name));
+        return false;
+    }
+    QLocalServer::removeServer(name);
+    server.setSocketOptions(QLocalServer::UserAccessOption);
+    return server.listen(name);
+}
+
+void ControlServer::send(QLocalSocket *socket, const QJsonDocument &doc) {
+    socket->write(doc.toJson(QJsonDocument::Compact) + '\n');
+}
+
+void ControlServer::handleLine(QLocalSocket *socket, const QByteArray &line) {
+    QPointer<QLocalSocket> target(socket);
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        send(socket, QJsonDocument(QJsonObject{{"jsonrpc", "2.0"}, {"id", QJsonValue()},
+            {"error", QJsonObject{{"code", -32700}, {"message", parseError.errorString()}}}}));
+        return;
+    }
+
+    if (!doc.isArray()) {
+        call(doc.object(), [target](const QJsonObject &response) {
+            if (target && !response.isEmpty()) send(target, QJsonDocument(response));
+        });
+        return;
+    }
+
+    // A batch is answered with one array once every call in it has completed.
+    const QJsonArray batch = doc.array();
+    if (batch.isEmpty()) {
+        send(socket, QJsonDocument(QJsonObject{{"jsonrpc", "2.0"}, {"id", QJsonValue()},
+            {"error", QJsonObject{{"code", -32600}, {"message", "Invalid request: empty batch"}}}}));
+        return;
+    }
+    auto responses = std::make_shared<QJsonArray>();
+    auto remaining = std::make_shared<int>(batch.size());
+    for (const QJsonValue &request : batch) {
+        call(request, [target, responses, remaining](const QJsonObject &response) {
+            if (!response.isEmpty()) responses->append(response);
+            if (--*remaining == 0 && target && !responses->isEmpty()) send(target, QJsonDocument(*responses));
+        });
+    }
+}
+
+void ControlServer::call(const QJsonValue &value, const std::function<void(const QJsonObject &)> &done) {
+    const QJsonObject request = value.toObject();
+    const QJsonValue id = request.value("id");
+    const bool notification = !request.contains("id");
+    auto answered = std::make_shared<bool>(false);
+    auto respond = [id, notification, done, answered](const QJsonValue &result, const QString &error, int code) {
+        if (*answered) return;
+        *answered = true;
+        if (notification) {
+            done(QJsonObject());
+            return;
+        }
+        QJsonObject response{{"jsonrpc", "2.0"}, {"id", id}};
+        if (error.isEmpty()) response["result"] = result;
+        else response["error"] = QJsonObject{{"code", code}, {"message", error}};
+        done(response);
+    };
+
+    const QString method = request.value("method").toString();
+    if (method.isEmpty()) {
+        respond(QJsonValue(), "Invalid request", -32600);
+        return;
+    }
+    const Method handler = methods.value(method);
+    if (!handler) {
+        respond(QJsonValue(), "Method not found: " + method, -32601);
+        return;
+    }
+    (this->*handler)(request.value("params").toObject(), [respond](const QJsonValue &result, const QString &error) {
+        respond(result, error, -32000);
+    });
+}
+
+QList<Browser*> ControlServer::windows() const {
+    QList<Browser*> out;
+    for (QWidget *w : QApplication::topLevelWidgets()) {
+        if (auto *browser = qobject_cast<Browser*>(w)) out.append(browser);
+    }
+    return out;
+}
+
+Browser *ControlServer::targetWindow(const QJsonObject &params) const {
+    const QList<Browser*> all = windows();
+    if (params.contains("window")) return all.value(params.value("window").toInt());
+    if (auto *active = qobject_cast<Browser*>(QApplication::activeWindow())) return active;
+    return all.value(0);
+}
+
+QWebEngineView *ControlServer::tab(const QJsonObject &params, QString *error) const {
+    QWebEngineView *view = PerfTracer::instance()->view(params.value("tab").toInt());
+    auto *window = view ? qobject_cast<Browser*>(view->window()) : nullptr;
+    if (!window || window->tabManager()->indexOf(view) == -1) {
+        *error = "No such tab";
+        return nullptr;
+    }
+    return view;
+}
+
+// load() only starts asynchronously, so a wait issued right after open or
+// navigate must not mistake the page for already loaded.
+void ControlServer::expectLoad(QWebEngineView *view) {
+    pendingLoads.insert(view);
+    if (watched.contains(view)) return;
+    watched.insert(view);
+    connect(view, &QWebEngineView::loadFinished, this, [this, view]() { pendingLoads.remove(view); });
+    connect(view, &QObject::destroyed, this, [this, view]() {
+        pendingLoads.remove(view);
+        watched.remove(view);
+    });
+}
+
+void ControlServer::listTabs(const QJsonObject &, const Reply &reply) {
+    QJsonArray out;
+    const QList<Browser*> all = windows();
+    for (int w = 0; w < all.size(); ++w) {
+        TabManager *tabs = all.at(w)->tabManager();
+        for (int i = 0; i < tabs->count(); ++i) {
+            QJsonObject o{{"window", w}, {"index", i}, {"current", i == tabs->currentIndex()}};
+            if (auto *view = qobject_cast<QWebEngineView*>(tabs->widget(i))) {
+                o["tab"] = PerfTracer::instance()->tabId(view);
+                o["url"] = view->url().toString();
+                o["title"] = view->title();
+                o["loading"] = pendingLoads.contains(view) || PerfTracer::instance()->isLoading(view);
+            } else {
+                // Restored but never opened: it gets an id once it is activated.
+                o["title"] = tabs->tabText(i);
+                o["unloaded"] = true;
+            }
+            out.append(o);
+        }
+    }
+    reply(out, QString());
+}
+
+void ControlServer::openTab(const QJsonObject &params, const Reply &reply) {
+    Browser *window = targetWindow(params);
+    if (!window) {
+        reply(QJsonValue(), "No window");
+        return;
+    }
+    TabManager *tabs = window->tabManager();
+    const int previous = tabs->currentIndex();
+    QWebEngineView *view = tabs->createNewTab(QUrl::fromUserInput(params.value("url").toString("about:blank")));
+    expectLoad(view);
+    if (params.value("background").toBool()) tabs->setCurrentIndex(previous);
+    reply(QJsonObject{{"tab", PerfTracer::instance()->tabId(view)}}, QString());
+}
+
+void ControlServer::closeTab(const QJsonObject &params, const Reply &reply) {
+    QString error;
+    QWebEngineView *view = tab(params, &error);
+    if (!view) {
+        reply(QJsonValue(), error);
+        return;
+    }
+    TabManager *tabs = qobject_cast<Browser*>(view->window())->tabManager();
+    if (tabs->count() <= 1) {
+        reply(QJsonValue(), "Cannot close the last tab of a window");
+        return;
+    }
+    tabs->closeTab(tabs->indexOf(view));
+    reply(true, QString());
+}
+
+void ControlServer::navigateTab(const QJsonObject &params, const Reply &reply) {
+    QString error;
+    QWebEngineView *view = tab(params, &error);
+    if (!view) {
+        reply(QJsonValue(), error);
+        return;
+    }
+    expectLoad(view);
+    qobject_cast<Browser*>(view->window())->tabManager()->navigate(view, QUrl::fromUserInput(params.value("url").toString()));
+    reply(true, QString());
+}
+
+void ControlServer::waitForLoad(const QJsonObject &params, const Reply &reply) {
+    QString error;
+    QWebEngineView *view = tab(params, &error);
+    if (!view) {
+        reply(QJsonValue(), error);
+        return;
+    }
+    if (!pendingLoads.contains(view) && !PerfTracer::instance()->isLoading(view)) {
+        reply(QJsonObject{{"ok", true}}, QString());
+        return;
+    }
+
+    auto *guard = new QObject(this);
+    connect(view, &QWebEngineView::loadFinished, guard, [guard, reply](bool ok) {
+        reply(QJsonObject{{"ok", ok}}, QString());
+        guard->deleteLater();
+    });
+    connect(view, &QObject::destroyed, guard, [guard, reply]() {
+        reply(QJsonValue(), "Tab closed");
+        guard->deleteLater();
+    });
+    QTimer::singleShot(params.value("timeoutMs").toInt(30000), guard, [guard, reply]() {
+        reply(QJsonValue(), "Timed out");
+        guard->deleteLater();
+    });
+}
+
+void ControlServer::evaluate(const QJsonObject &params, const Reply &reply) {
+    QString error;
+    QWebEngineView *view = tab(params, &error);
+    if (!view) {
+        reply(QJsonValue(), error);
+        return;
+    }
+    // A result can be lost with the page, so the call also ends when the tab
+    // goes away, navigates, or runs out of time; whichever is first answers.
+    auto *guard = new QObject(this);
+    connect(view, &QObject::destroyed, guard, [guard, reply]() {
+        reply(QJsonValue(), "Tab closed");
+        guard->deleteLater();
+    });
+    connect(view, &QWebEngineView::loadStarted, guard, [guard, reply]() {
+        reply(QJsonValue(), "Navigated away");
+        guard->deleteLater();
+    });
+    QTimer::singleShot(params.value("timeoutMs").toInt(30000), guard, [guard, reply]() {
+        reply(QJsonValue(), "Timed out");
+        guard->deleteLater();
+    });
+    QPointer<QObject> pending(guard);
+    view->page()->runJavaScript(params.value("script").toString(), [pending, reply](const QVariant &result) {
+        if (!pending) return;
+        reply(QJsonValue::fromVariant(result), QString());
+        pending->deleteLater();
+    });
+}
+
+void ControlServer::screenshot(const QJsonObject &params, const Reply &reply) {
+    QString error;
+    QWebEngineView *view = tab(params, &error);
+    if (!view) {
+        reply(QJsonValue(), error);
+        return;
+    }
+    // Only the visible tab is composited, so bring it to the front first.
+    TabManager *tabs = qobject_cast<Browser*>(view->window())->tabManager();
+    const bool wasCurrent = tabs->currentWidget() == view;
+    if (!wasCurrent) tabs->activateTab(tabs->indexOf(view));
+
+    // As in evaluate(), the guard answers if the tab closes during the wait.
+    auto *guard = new QObject(this);
+    connect(view, &QObject::destroyed, guard, [guard, reply]() {
+        reply(QJsonValue(), "Tab closed");
+        guard->deleteLater();
+    });
+    const QString path = params.value("path").toString();
+    QTimer::singleShot(wasCurrent ? 0 : 150, guard, [guard, view, path, reply]() {
+        view->disconnect(guard);
+        guard->deleteLater();
+        const QImage image = view->grab().toImage();
+        if (!path.isEmpty()) {
+            if (image.save(path, "PNG")) reply(QJsonObject{{"path", path}}, QString());
+            else reply(QJsonValue(), "Cannot write " + path);
+            return;
+        }
+        QByteArray png;
+        QBuffer buffer(&png);
+        buffer.open(QIODevice::WriteOnly);
+        image.save(&buffer, "PNG");
+        reply(QJsonObject{{"png", QString::fromLatin1(png.toBase64())}}, QString());
+    });
+}
+
+void ControlServer::queryHistory(const QJsonObject &params, const Reply &reply) {
+    Browser *window = targetWindow(params);
+    if (!window) {
+        reply(QJsonValue(), "No window");
+        return;
+    }
+    Profile *profile = window->profile();
+    const int max = params.value("max").toInt(20);
+    const QString text = params.value("text").toString();
+    if (text.isEmpty()) {
+        reply(QJsonDocument::fromJson(profile->history()->recentJson(-1, max).toUtf8())["entries"].toArray(), QString());
+        return;
+    }
+    QJsonArray out;
+    for (int id : profile->suggestions()->query(text, max)) {
+        const HistoryEntry &e = profile->history()->entry(id);
+        out.append(QJsonObject{{"url", e.url}, {"title", e.title}, {"visits", int(e.visits)}, {"lastVisit", e.lastVisit}});
+    }
+    reply(out, QString());
+}
+
+void ControlServer::metrics(const QJsonObject &, const Reply &reply) {
+    QJsonArray perWindow;
+    for (Browser *window : windows()) {
+        perWindow.append(QJsonObject{
+            {"profile", window->profile()->name()},
+            {"tabs", window->tabManager()->count()},
+            {"liveTabs", window->tabManager()->lifecycle()->liveTabCount()},
+            {"blockedRequests", window->profile()->blocker()->blockedCount()}});
+    }
+    QJsonObject result = QJsonDocument::fromJson(PerfTracer::instance()->summary().toUtf8()).object();
+    result["windows"] = perWindow;
+    reply(result, QString());
+}
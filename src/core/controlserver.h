@@ -0,0 +1,57 @@
+#ifndef CONTROLSERVER_H
+#define CONTROLSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QSet>
+#include <functional>
+
+class Browser;
+class QLocalSocket;
+class QWebEngineView;
+
+// JSON-RPC 2.0 over a local socket (--control-socket) for driving Capture
+// from scripts and test harnesses. Messages are newline-delimited; a line may
+// hold one request or a batch array. Requests on a connection are pipelined:
+// each one is answered as soon as it completes, so slow calls such as
+// tabs.waitForLoad never hold up the ones behind them.
+class ControlServer : public QObject {
+    Q_OBJECT
+public:
+    explicit ControlServer(const QString &name, QObject *parent = nullptr);
+    bool start();
+    QString fullServerName() const { return server.fullServerName(); }
+
+private:
+    using Reply = std::function<void(const QJsonValue &result, const QString &error)>;
+    using Method = void (ControlServer::*)(const QJsonObject &params, const Reply &reply);
+
+    QString name;
+    QLocalServer server;
+    QHash<QString, Method> methods;
+    QSet<QWebEngineView*> pendingLoads;
+    QSet<QWebEngineView*> watched;
+
+    void handleLine(QLocalSocket *socket, const QByteArray &line);
+    void call(const QJsonValue &request, const std::function<void(const QJsonObject &)> &done);
+    static void send(QLocalSocket *socket, const QJsonDocument &doc);
+
+    QList<Browser*> windows() const;
+    Browser *targetWindow(const QJsonObject &params) const;
+    QWebEngineView *tab(const QJsonObject &params, QString *error) const;
+    void expectLoad(QWebEngineView *view);
+
+    void listTabs(const QJsonObject &params, const Reply &reply);
+    void openTab(const QJsonObject &params, const Reply &reply);
+    void closeTab(const QJsonObject &params, const Reply &reply);
+    void navigateTab(const QJsonObject &params, const Reply &reply);
+    void waitForLoad(const QJsonObject &params, const Reply &reply);
+    void evaluate(const QJsonObject &params, const Reply &reply);
+    void screenshot(const QJsonObject &params, const Reply &reply);
+    void queryHistory(const QJsonObject &params, const Reply &reply);
+    void metrics(const QJsonObject &params, const Reply &reply);
+};
+
+#endif
@@ -0,0 +1,394 @@
+#include "downloadmanager.h"
+#include <QDesktopServices>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLabel>
+#include <QLocale>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QSaveFile>
+#include <QScrollArea>
+#include <QStandardPaths>
+#include <QVBoxLayout>
+
+static const int MaxRemembered = 100;
+
+qint64 DownloadItem::etaSeconds() const {
+    if (totalBytes <= 0 || bytesPerSecond <= 0) return -1;
+    return qint64((totalBytes - receivedBytes) / bytesPerSecond);
+}
+
+DownloadManager::DownloadManager(QWebEngineProfile *profile, const QString &statePath, QObject *parent)
+    : QObject(parent), profile(profile), statePath(statePath),
+      directory(QStandardPaths::writableLocation(QStandardPaths::DownloadLocation)) {
+    saveTimer.setSingleShot(true);
+    saveTimer.setInterval(1000);
+    connect(&saveTimer, &QTimer::timeout, this, &DownloadManager::save);
+    connect(profile, &QWebEngineProfile::downloadRequested, this, &DownloadManager::add);
+    load();
+}
+
+void DownloadManager::setMaxConcurrent(int count) {
+    maxConcurrent = qMax(1, count);
+    schedule();
+}
+
+QString DownloadManager::uniqueFileName(const QString &dir, const QString &name) const {
+    QFileInfo info(name);
+    QString candidate = name;
+    for (int n = 1; QFile::exists(dir + "/" + candidate); ++n) {
+        candidate = info.suffix().isEmpty()
+            ? QString("%1 (%2)").arg(info.completeBaseName()).arg(n)
+            : QString("%1 (%2).%3").arg(info.completeBaseName()).arg(n).arg(info.suffix());
+    }
+    return candidate;
+}
+
+void DownloadManager::add(QWebEngineDownloadRequest *download) {
+    // A restart we issued ourselves picks its old row back up.
+    int i = -1;
+    for (int j = 0; j < items.size(); ++j) {
+        if (!items.at(j).request && items.at(j).status == DownloadItem::Queued && items.at(j).url == download->url()) {
+            i = j;
+            break;
+        }
+    }
+
+    if (i == -1) {
+        DownloadItem item;
+        item.url = download->url();
+        item.directory = directory;
+        item.fileName = uniqueFileName(directory, download->suggestedFileName());
+        items.append(item);
+        i = items.size() - 1;
+        emit itemAdded(i);
+    }
+
+    DownloadItem &item = items[i];
+    QDir().mkpath(item.directory);
+    download->setDownloadDirectory(item.directory);
+    download->setDownloadFileName(item.fileName);
+    item.receivedBytes = 0;
+    item.error.clear();
+    item.status = DownloadItem::Queued;
+    track(i, download);
+    download->accept();
+    onState(i, download->state());
+}
+
+void DownloadManager::track(int i, QWebEngineDownloadRequest *download) {
+    items[i].request = download;
+    connect(download, &QWebEngineDownloadRequest::receivedBytesChanged, this, [this, i]() { onProgress(i); });
+    connect(download, &QWebEngineDownloadRequest::totalBytesChanged, this, [this, i]() { onProgress(i); });
+    connect(download, &QWebEngineDownloadRequest::stateChanged, this,
+            [this, i](QWebEngineDownloadRequest::DownloadState state) { onState(i, state); });
+}
+
+void DownloadManager::onState(int i, QWebEngineDownloadRequest::DownloadState state) {
+    DownloadItem &item = items[i];
+    switch (state) {
+    case QWebEngineDownloadRequest::DownloadInProgress:
+        if (item.status == DownloadItem::Queued) item.request->pause();
+        break;
+    case QWebEngineDownloadRequest::DownloadCompleted:
+        item.status = DownloadItem::Completed;
+        item.receivedBytes = item.request->receivedBytes();
+        item.totalBytes = item.receivedBytes;
+        break;
+    case QWebEngineDownloadRequest::DownloadCancelled:
+        item.status = DownloadItem::Cancelled;
+        break;
+    case QWebEngineDownloadRequest::DownloadInterrupted:
+        item.status = DownloadItem::Failed;
+        item.error = item.request->interruptReasonString();
+        break;
+    default:
+        break;
+    }
+    schedule();
+    emit itemChanged(i);
+    saveTimer.start();
+}
+
+void DownloadManager::onProgress(int i) {
+    DownloadItem &item = items[i];
+    if (!item.request) return;
+    item.receivedBytes = item.request->receivedBytes();
+    item.totalBytes = item.request->totalBytes();
+
+    if (!item.sampleClock.isValid()) {
+        item.sampleClock.start();
+        item.sampleBytes = item.receivedBytes;
+    } else if (item.sampleClock.elapsed() >= 500) {
+        const double rate = (item.receivedBytes - item.sampleBytes) * 1000.0 / item.sampleClock.restart();
+        item.sampleBytes = item.receivedBytes;
+        item.bytesPerSecond = item.bytesPerSecond > 0 ? 0.7 * item.bytesPerSecond + 0.3 * rate : rate;
+    }
+    emit itemChanged(i);
+}
+
+void DownloadManager::schedule() {
+    int active = 0;
+    for (const DownloadItem &item : std::as_const(items)) {
+        if (item.status == DownloadItem::Active) active++;
+    }
+    for (int i = 0; i < items.size() && active < maxConcurrent; ++i) {
+        DownloadItem &item = items[i];
+        if (item.status != DownloadItem::Queued || !item.request) continue;
+        if (item.request->state() != QWebEngineDownloadRequest::DownloadInProgress) continue;
+        item.status = DownloadItem::Active;
+        item.sampleClock.invalidate();
+        item.request->resume();
+        active++;
+        emit itemChanged(i);
+    }
+}
+
+void DownloadManager::pause(int i) {
+    if (i < 0 || i >= items.size()) return;
+    DownloadItem &item = items[i];
+    if (item.status != DownloadItem::Active && item.status != DownloadItem::Queued) return;
+    if (item.request) item.request->pause();
+    item.status = DownloadItem::Paused;
+    item.bytesPerSecond = 0;
+    schedule();
+    emit itemChanged(i);
+    saveTimer.start();
+}
+
+void DownloadManager::resume(int i) {
+    if (i < 0 || i >= items.size()) return;
+    DownloadItem &item = items[i];
+    if (item.status != DownloadItem::Paused && item.status != DownloadItem::Failed
+            && item.status != DownloadItem::Cancelled) return;
+
+    // Only a paused transfer can carry on from where it stopped. An interrupted
+    // request cannot be resumed through the public API, so it is requested
+    // again, as is anything cancelled or older than this process.
+    if (!item.request || item.status == DownloadItem::Cancelled
+            || item.request->state() == QWebEngineDownloadRequest::DownloadInterrupted) {
+        restart(i);
+        return;
+    }
+    item.status = DownloadItem::Queued;
+    schedule();
+    emit itemChanged(i);
+}
+
+void DownloadManager::restart(int i) {
+    if (!helper) helper = new QWebEnginePage(profile, this);
+    if (items.at(i).request) items[i].request->disconnect(this);
+    items[i].request = nullptr;
+    items[i].status = DownloadItem::Queued;
+    QFile::remove(items.at(i).filePath());
+    helper->download(items.at(i).url, items.at(i).filePath());
+    emit itemChanged(i);
+}
+
+void DownloadManager::cancel(int i) {
+    if (i < 0 || i >= items.size()) return;
+    DownloadItem &item = items[i];
+    if (item.request) item.request->cancel();
+    item.status = DownloadItem::Cancelled;
+    schedule();
+    emit itemChanged(i);
+    saveTimer.start();
+}
+
+QString DownloadManager::itemsJson() const {
+    QJsonArray array;
+    for (int i = items.size() - 1; i >= 0; --i) {
+        const DownloadItem &item = items.at(i);
+        QJsonObject o;
+        o["index"] = i;
+        o["url"] = item.url.toString();
+        o["fileName"] = item.fileName;
+        o["received"] = double(item.receivedBytes);
+        o["total"] = double(item.totalBytes);
+        o["status"] = int(item.status);
+        o["error"] = item.error;
+        array.append(o);
+    }
+    return QString::fromUtf8(QJsonDocument(array).toJson(QJsonDocument::Compact));
+}
+
+void DownloadManager::load() {
+    if (statePath.isEmpty()) return;
+    QFile f(statePath);
+    if (!f.open(QIODevice::ReadOnly)) return;
+
+    const QJsonArray array = QJsonDocument::fromJson(f.readAll()).array();
+    for (const QJsonValue &v : array) {
+        const QJsonObject o = v.toObject();
+        DownloadItem item;
+        item.url = QUrl(o["url"].toString());
+        item.directory = o["directory"].toString();
+        item.fileName = o["fileName"].toString();
+        item.receivedBytes = qint64(o["received"].toDouble());
+        item.totalBytes = qint64(o["total"].toDouble(-1));
+        item.status = DownloadItem::Status(o["status"].toInt());
+        item.error = o["error"].toString();
+        // Whatever was still moving when the last session ended waits for the user.
+        if (item.status == DownloadItem::Queued || item.status == DownloadItem::Active) item.status = DownloadItem::Paused;
+        items.append(item);
+    }
+}
+
+void DownloadManager::save() {
+    if (statePath.isEmpty()) return;
+    QJsonArray array;
+    for (int i = qMax(0, int(items.size()) - MaxRemembered); i < items.size(); ++i) {
+        const DownloadItem &item = items.at(i);
+        QJsonObject o;
+        o["url"] = item.url.toString();
+        o["directory"] = item.directory;
+        o["fileName"] = item.fileName;
+        o["received"] = double(item.receivedBytes);
+        o["total"] = double(item.totalBytes);
+        o["status"] = int(item.status);
+        o["error"] = item.error;
+        array.append(o);
+    }
+    QSaveFile f(statePath);
+    if (!f.open(QIODevice::WriteOnly)) return;
+    f.write(QJsonDocument(array).toJson(QJsonDocument::Compact));
+    f.commit();
+}
+
+class DownloadRow : public QWidget {
+public:
+    QLabel *name;
+    QLabel *status;
+    QProgressBar *bar;
+    QPushButton *action;
+    QPushButton *cancel;
+
+    explicit DownloadRow(QWidget *parent = nullptr) : QWidget(parent) {
+        auto *layout = new QVBoxLayout(this);
+        layout->setContentsMargins(0, 4, 0, 4);
+        name = new QLabel;
+        name->setWordWrap(true);
+        bar = new QProgressBar;
+        bar->setTextVisible(false);
+        bar->setFixedHeight(8);
+        status = new QLabel;
+
+        auto *buttons = new QHBoxLayout;
+        action = new QPushButton;
+        cancel = new QPushButton("Cancel");
+        buttons->addWidget(status, 1);
+        buttons->addWidget(action);
+        buttons->addWidget(cancel);
+
+        layout->addWidget(name);
+        layout->addWidget(bar);
+        layout->addLayout(buttons);
+    }
+};
+
+DownloadPanel::DownloadPanel(DownloadManager *manager, QWidget *parent) : QFrame(parent), manager(manager) {
+    setFixedSize(360, 320);
+    // Rows are added per download, so the panel takes the window's theme
+    // palette rather than a style sheet every new row would be matched against.
+    setFrameShape(QFrame::StyledPanel);
+    setBackgroundRole(QPalette::AlternateBase);
+    setAutoFillBackground(true);
+
+    auto *layout = new QVBoxLayout(this);
+    auto *header = new QHBoxLayout;
+    auto *close = new QPushButton("x");
+    header->addWidget(new QLabel("<b>Downloads</b>"), 1);
+    header->addWidget(close);
+    layout->addLayout(header);
+
+    auto *list = new QWidget;
+    rows = new QVBoxLayout(list);
+    rows->setContentsMargins(0, 0, 0, 0);
+    rows->addStretch();
+    auto *scroll = new QScrollArea;
+    scroll->setWidgetResizable(true);
+    scroll->setFrameShape(QFrame::NoFrame);
+    scroll->setWidget(list);
+    layout->addWidget(scroll);
+
+    connect(close, &QPushButton::clicked, this, &QWidget::hide);
+    connect(manager, &DownloadManager::itemAdded, this, &DownloadPanel::addRow);
+    connect(manager, &DownloadManager::itemChanged, this, &DownloadPanel::updateRow);
+    for (int i = 0; i < manager->count(); ++i) addRow(i);
+    hide();
+}
+
+void DownloadPanel::reposition() {
+    if (parentWidget()) move(parentWidget()->width() - width() - 20, 40);
+}
+
+void DownloadPanel::addRow(int i) {
+    auto *row = new DownloadRow;
+    // Newest first: insert above the older rows.
+    rows->insertWidget(0, row);
+    rowWidgets.append(row);
+
+    connect(row->action, &QPushButton::clicked, this, [this, i]() {
+        const DownloadItem &item = manager->item(i);
+        if (item.status == DownloadItem::Active || item.status == DownloadItem::Queued) manager->pause(i);
+        else if (item.status == DownloadItem::Completed) QDesktopServices::openUrl(QUrl::fromLocalFile(item.filePath()));
+        else manager->resume(i);
+    });
+    connect(row->cancel, &QPushButton::clicked, this, [this, i]() { manager->cancel(i); });
+    updateRow(i);
+}
+
+void DownloadPanel::updateRow(int i) {
+    if (i >= rowWidgets.size()) return;
+    auto *row = static_cast<DownloadRow*>(rowWidgets.at(i));
+    const DownloadItem &item = manager->item(i);
+    QLocale locale;
+
+    row->name->setText(item.fileName);
+    if (item.totalBytes > 0) {
+        row->bar->setRange(0, 1000);
+        row->bar->setValue(int(item.receivedBytes * 1000 / item.totalBytes));
+    } else {
+        // Unknown size: keep the bar busy instead of dividing by zero.
+        row->bar->setRange(0, item.status == DownloadItem::Active ? 0 : 1);
+        row->bar->setValue(item.status == DownloadItem::Completed ? 1 : 0);
+    }
+
+    QString text = locale.formattedDataSize(item.receivedBytes);
+    if (item.totalBytes > 0) text += " of " + locale.formattedDataSize(item.totalBytes);
+    switch (item.status) {
+    case DownloadItem::Active:
+        if (item.bytesPerSecond > 0) text += " - " + locale.formattedDataSize(qint64(item.bytesPerSecond)) + "/s";
+        if (item.etaSeconds() >= 0) text += QString(" - %1 s left").arg(item.etaSeconds());
+        row->action->setText("Pause");
+        break;
+    case DownloadItem::Queued:
+        text = "Queued";
+        row->action->setText("Pause");
+        break;
+    case DownloadItem::Paused:
+        text += " - Paused";
+        row->action->setText("Resume");
+        break;
+    case DownloadItem::Completed:
+        text = "Done - " + locale.formattedDataSize(item.totalBytes);
+        row->action->setText("Open");
+        break;
+    case DownloadItem::Failed:
+        text = "Failed: " + item.error;
+        row->action->setText("Retry");
+        break;
+    case DownloadItem::Cancelled:
+        text = "Cancelled";
+        row->action->setText("Retry");
+        break;
+    }
+    row->status->setText(text);
+    row->cancel->setVisible(item.status == DownloadItem::Active || item.status == DownloadItem::Queued
+                            || item.status == DownloadItem::Paused);
+}
@@ -0,0 +1,97 @@
+#ifndef DOWNLOADMANAGER_H
+#define DOWNLOADMANAGER_H
+
+#include <QObject>
+#include <QFrame>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QTimer>
+#include <QUrl>
+#include <QVector>
+#include <QWebEngineDownloadRequest>
+#include <QWebEnginePage>
+#include <QWebEngineProfile>
+
+class QVBoxLayout;
+
+struct DownloadItem {
+    enum Status { Queued, Active, Paused, Completed, Failed, Cancelled };
+
+    QUrl url;
+    QString directory;
+    QString fileName;
+    qint64 receivedBytes = 0;
+    qint64 totalBytes = -1;
+    Status status = Queued;
+    QString error;
+    double bytesPerSecond = 0;
+    QPointer<QWebEngineDownloadRequest> request;
+    qint64 sampleBytes = 0;
+    QElapsedTimer sampleClock;
+
+    QString filePath() const { return directory + "/" + fileName; }
+    qint64 etaSeconds() const;
+};
+
+// Per-profile download queue. Accepted downloads beyond the concurrency limit
+// are held paused until a slot frees up. The queue is persisted so that
+// downloads cut short by a restart can be restarted from the panel.
+class DownloadManager : public QObject {
+    Q_OBJECT
+public:
+    DownloadManager(QWebEngineProfile *profile, const QString &statePath, QObject *parent = nullptr);
+
+    void setMaxConcurrent(int count);
+    void setDirectory(const QString &dir) { directory = dir; }
+
+    int count() const { return items.size(); }
+    const DownloadItem &item(int i) const { return items.at(i); }
+
+    Q_INVOKABLE void pause(int i);
+    Q_INVOKABLE void resume(int i);
+    Q_INVOKABLE void cancel(int i);
+    Q_INVOKABLE QString itemsJson() const;
+
+signals:
+    void itemAdded(int i);
+    void itemChanged(int i);
+
+private slots:
+    void add(QWebEngineDownloadRequest *download);
+
+private:
+    QWebEngineProfile *profile;
+    QString statePath;
+    QString directory;
+    QVector<DownloadItem> items;
+    QWebEnginePage *helper = nullptr;
+    QTimer saveTimer;
+    int maxConcurrent = 3;
+
+    void track(int i, QWebEngineDownloadRequest *download);
+    void onState(int i, QWebEngineDownloadRequest::DownloadState state);
+    void onProgress(int i);
+    void schedule();
+    void restart(int i);
+    void load();
+    void save();
+    QString uniqueFileName(const QString &dir, const QString &name) const;
+};
+
+// One aggregated panel listing every download of a profile.
+class DownloadPanel : public QFrame {
+    Q_OBJECT
+public:
+    explicit DownloadPanel(DownloadManager *manager, QWidget *parent = nullptr);
+    void reposition();
+
+private:
+    DownloadManager *manager;
+    QVBoxLayout *rows;
+    QList<QWidget*> rowWidgets;
+
+    void addRow(int i);
+    void updateRow(int i);
+};
+
+#endif
@@ -0,0 +1,199 @@
+#include "headlesscapture.h"
+#include "profile.h"
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QWebEnginePage>
+#include <cstdio>
+
+HeadlessCapture::HeadlessCapture(Profile *profile, const CaptureOptions &options, QObject *parent)
+    : QObject(parent), profile(profile), options(options) {
+    profile->retain();
+}
+
+HeadlessCapture::~HeadlessCapture() {
+    for (Worker *w : std::as_const(workers)) {
+        delete w->view;
+        delete w;
+    }
+    profile->release();
+}
+
+bool HeadlessCapture::start() {
+    QString text;
+    if (options.input.isEmpty() || options.input == "-") {
+        QTextStream in(stdin);
+        text = in.readAll();
+    } else {
+        QFile f(options.input);
+        if (!f.open(QIODevice::ReadOnly)) {
+            std::fprintf(stderr, "capture: cannot read %s\n", qPrintable(options.input));
+            return false;
+        }
+        text = QString::fromUtf8(f.readAll());
+    }
+    for (const QString &line : text.split('\n')) {
+        const QString trimmed = line.trimmed();
+        if (trimmed.isEmpty() || trimmed.startsWith('#')) continue;
+        urls.append(QUrl::fromUserInput(trimmed));
+        attempts.append(0);
+    }
+    if (urls.isEmpty()) {
+        std::fprintf(stderr, "capture: no URLs to capture\n");
+        return false;
+    }
+
+    QDir().mkpath(options.outputDir);
+    results.setFileName(options.outputDir + "/results.jsonl");
+    if (!results.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+
+    total.start();
+    const int poolSize = qBound(1, options.jobs, int(urls.size()));
+    for (int i = 0; i < poolSize; ++i) {
+        auto *w = new Worker;
+        w->view = new QWebEngineView;
+        attachPage(w);
+        w->view->resize(options.width, 800);
+        w->view->show();
+        w->timeout.setSingleShot(true);
+        workers.append(w);
+
+        connect(&w->timeout, &QTimer::timeout, this, [this, w]() {
+            w->token++;
+            fail(w, "timeout");
+            w->view->stop();
+        });
+        dispatch(w);
+    }
+    return true;
+}
+
+// Callbacks are tied to the page they were connected on. After a failure the
+// page is replaced, so an aborted navigation's late loadFinished(false) or a
+// PDF still being written lands on a dead token instead of the next job.
+void HeadlessCapture::attachPage(Worker *w) {
+    QWebEnginePage *old = w->view->page();
+    auto *page = new QWebEnginePage(profile->web(), w->view);
+    const int token = ++w->pageToken;
+    connect(page, &QWebEnginePage::loadFinished, this, [this, w, token](bool ok) {
+        if (token != w->pageToken || w->job == -1) return;
+        if (ok) capture(w);
+        else fail(w, "load failed");
+    });
+    connect(page, &QWebEnginePage::pdfPrintingFinished, this, [this, w, token](const QString &path, bool ok) {
+        if (token != w->pageToken || w->job == -1 || path != w->pdf) return;
+        if (ok) complete(w, path);
+        else fail(w, "pdf failed");
+    });
+    w->view->setPage(page);
+    if (old && old->parent() == w->view) {
+        old->disconnect(this);
+        old->deleteLater();
+    }
+}
+
+QString HeadlessCapture::outputBase(int job) const {
+    QString host = urls.at(job).host();
+    host.replace(QRegularExpression("[^A-Za-z0-9.-]"), "_");
+    return QString("%1/%2-%3").arg(options.outputDir).arg(job + 1, 4, 10, QChar('0')).arg(host);
+}
+
+void HeadlessCapture::dispatch(Worker *w) {
+    if (!retryQueue.isEmpty()) {
+        w->job = retryQueue.takeFirst();
+    } else if (next < urls.size()) {
+        w->job = next++;
+    } else {
+        w->job = -1;
+        finishIfIdle();
+        return;
+    }
+    if (w->replacePage) {
+        w->replacePage = false;
+        attachPage(w);
+    }
+    attempts[w->job]++;
+    w->token++;
+    w->png.clear();
+    w->pdf.clear();
+    w->clock.start();
+    w->view->resize(options.width, 800);
+    w->timeout.start(options.timeoutMs);
+    w->view->load(urls.at(w->job));
+}
+
+void HeadlessCapture::capture(Worker *w) {
+    // Grow the view to the document so one grab covers the whole page; Chromium
+    // needs a moment to relayout and paint at the new size.
+    const QSize contents = w->view->page()->contentsSize().toSize();
+    w->view->resize(options.width, qBound(800, contents.height(), 16384));
+    // A later loadFinished (client redirect) supersedes this grab.
+    const int token = ++w->token;
+    QTimer::singleShot(300, this, [this, w, token]() {
+        if (token != w->token || w->job == -1) return;
+        const QString base = outputBase(w->job);
+        if (options.png) {
+            w->png = base + ".png";
+            if (!w->view->grab().save(w->png)) {
+                fail(w, "cannot write " + w->png);
+                return;
+            }
+        }
+        if (options.pdf) {
+            w->pdf = base + ".pdf";
+            w->view->page()->printToPdf(w->pdf);
+        }
+        else complete(w, QString());
+    });
+}
+
+void HeadlessCapture::complete(Worker *w, const QString &pdf) {
+    w->timeout.stop();
+    succeeded++;
+    writeResult(w, "ok", w->png, pdf, QString());
+    dispatch(w);
+}
+
+void HeadlessCapture::fail(Worker *w, const QString &error) {
+    if (w->job == -1) return;
+    w->timeout.stop();
+    const int job = w->job;
+    if (attempts.at(job) <= options.retries) {
+        retryQueue.append(job);
+    } else {
+        failed++;
+        writeResult(w, error == "timeout" ? "timeout" : "failed", QString(), QString(), error);
+    }
+    w->job = -1;
+    // Leave the failed navigation's callbacks behind before reusing the view.
+    w->replacePage = true;
+    QTimer::singleShot(0, this, [this, w]() { dispatch(w); });
+}
+
+void HeadlessCapture::writeResult(Worker *w, const QString &status, const QString &png, const QString &pdf, const QString &error) {
+    QJsonObject o;
+    o["url"] = urls.at(w->job).toString();
+    o["status"] = status;
+    o["attempts"] = attempts.at(w->job);
+    o["ms"] = double(w->clock.elapsed());
+    if (!png.isEmpty()) o["png"] = png;
+    if (!pdf.isEmpty()) o["pdf"] = pdf;
+    if (!error.isEmpty()) o["error"] = error;
+    results.write(QJsonDocument(o).toJson(QJsonDocument::Compact) + "\n");
+    results.flush();
+}
+
+void HeadlessCapture::finishIfIdle() {
+    for (Worker *w : std::as_const(workers)) {
+        if (w->job != -1) return;
+    }
+    if (!retryQueue.isEmpty()) return;
+
+    const double minutes = total.elapsed() / 60000.0;
+    std::fprintf(stderr, "capture: %d ok, %d failed in %.1f s with %d workers (%.1f pages/min)\n",
+                 succeeded, failed, total.elapsed() / 1000.0, int(workers.size()),
+                 minutes > 0 ? (succeeded + failed) / minutes : 0.0);
+    emit finished(succeeded, failed);
+}
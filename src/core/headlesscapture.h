@@ -0,0 +1,74 @@
+#ifndef HEADLESSCAPTURE_H
+#define HEADLESSCAPTURE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QTimer>
+#include <QUrl>
+#include <QWebEngineView>
+
+class Profile;
+
+struct CaptureOptions {
+    QString input;
+    QString outputDir;
+    int jobs = 4;
+    int timeoutMs = 30000;
+    int retries = 1;
+    bool png = true;
+    bool pdf = false;
+    int width = 1280;
+};
+
+// Batch renderer behind --headless: drives a pool of offscreen views over a
+// URL list, writing full-page PNGs and/or PDFs plus one JSON line per URL to
+// results.jsonl in the output directory.
+class HeadlessCapture : public QObject {
+    Q_OBJECT
+public:
+    HeadlessCapture(Profile *profile, const CaptureOptions &options, QObject *parent = nullptr);
+    ~HeadlessCapture();
+    bool start();
+
+signals:
+    // Once every URL has succeeded or run out of retries.
+    void finished(int succeeded, int failed);
+
+private:
+    struct Worker {
+        QWebEngineView *view;
+        QTimer timeout;
+        QElapsedTimer clock;
+        int job = -1;
+        int token = 0;
+        int pageToken = 0;
+        bool replacePage = false;
+        QString png;
+        QString pdf;
+    };
+
+    Profile *profile;
+    CaptureOptions options;
+    QList<QUrl> urls;
+    QList<int> attempts;
+    QList<int> retryQueue;
+    QList<Worker*> workers;
+    QFile results;
+    QElapsedTimer total;
+    int next = 0;
+    int succeeded = 0;
+    int failed = 0;
+
+    void attachPage(Worker *w);
+    void dispatch(Worker *w);
+    void capture(Worker *w);
+    void complete(Worker *w, const QString &pdf);
+    void fail(Worker *w, const QString &error);
+    void writeResult(Worker *w, const QString &status, const QString &png, const QString &pdf, const QString &error);
+    QString outputBase(int job) const;
+    void finishIfIdle();
+};
+
+#endif
@@ -0,0 +1,210 @@
+#include "historystore.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThreadPool>
+#include <algorithm>
+
+static void writeRecord(QDataStream &out, const HistoryEntry &e) {
+    out << e.url << e.title << e.lastVisit << e.visits;
+}
+
+HistoryStore::HistoryStore(const QString &path, QObject *parent) : QObject(parent), path(path) {
+    load();
+    openLog();
+}
+
+HistoryStore::~HistoryStore() {
+    // A running compaction only touches its own copy and the .compact file.
+    if (compacting) QThreadPool::globalInstance()->waitForDone();
+}
+
+QString HistoryStore::normalize(const QUrl &url) {
+    return url.adjusted(QUrl::RemoveFragment | QUrl::NormalizePathSegments | QUrl::StripTrailingSlash).toString();
+}
+
+void HistoryStore::load() {
+    if (path.isEmpty()) return;
+    const QString compacted = path + ".compact";
+    // A crash between removing the old log and renaming the compacted one
+    // leaves only the compacted file behind.
+    if (!QFile::exists(path) && QFile::exists(compacted)) QFile::rename(compacted, path);
+    else QFile::remove(compacted);
+
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return;
+    QDataStream in(&f);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    qint64 validEnd = 0;
+    while (!in.atEnd()) {
+        HistoryEntry e;
+        in >> e.url >> e.title >> e.lastVisit >> e.visits;
+        if (in.status() != QDataStream::Ok) break;
+        upsert(e);
+        logRecords++;
+        validEnd = f.pos();
+    }
+    const qint64 size = f.size();
+    f.close();
+    // Drop a record torn by a crash so later appends stay readable.
+    if (validEnd < size) QFile::resize(path, validEnd);
+}
+
+void HistoryStore::openLog() {
+    if (path.isEmpty()) return;
+    log.setFileName(path);
+    log.open(QIODevice::WriteOnly | QIODevice::Append);
+}
+
+void HistoryStore::upsert(const HistoryEntry &e) {
+    int id = index.value(e.url, -1);
+    if (id == -1) {
+        id = entries.size();
+        entries.append(e);
+        index.insert(e.url, id);
+    } else {
+        entries[id] = e;
+    }
+    entries[id].lastSeq = visitOrder.size();
+    visitOrder.append(id);
+}
+
+void HistoryStore::append(const HistoryEntry &e) {
+    if (!log.isOpen()) return;
+    QDataStream out(&log);
+    out.setVersion(QDataStream::Qt_6_0);
+    writeRecord(out, e);
+    log.flush();
+    logRecords++;
+    if (compacting) pending.append(e);
+}
+
+int HistoryStore::addVisit(const QUrl &url, const QString &title) {
+    const QString key = normalize(url);
+    if (key.isEmpty()) return -1;
+
+    const int existing = index.value(key, -1);
+    HistoryEntry e = existing == -1 ? HistoryEntry() : entries.at(existing);
+    e.url = key;
+    if (!title.isEmpty()) e.title = title;
+    e.lastVisit = QDateTime::currentMSecsSinceEpoch();
+    e.visits++;
+
+    upsert(e);
+    append(e);
+    const int id = index.value(key);
+    if (existing == -1) emit entryAdded(id);
+    else emit entryUpdated(id);
+
+    if (visitOrder.size() > 2 * entries.size() + 1024) rebuildOrder();
+    if (!compacting && logRecords > 2 * entries.size() + 1024) compact();
+    return id;
+}
+
+QList<int> HistoryStore::recent(int &cursor, int max, const QString &filter, int scanLimit) const {
+    QList<int> out;
+    int scanned = 0;
+    while (cursor >= 0 && out.size() < max) {
+        if (!filter.isEmpty() && scanned++ == scanLimit) break;
+        const int id = visitOrder.at(cursor);
+        const HistoryEntry &e = entries.at(id);
+        if (e.lastSeq == cursor && (filter.isEmpty() || e.title.contains(filter, Qt::CaseInsensitive)
+                                    || e.url.contains(filter, Qt::CaseInsensitive))) {
+            out.append(id);
+        }
+        cursor--;
+    }
+    return out;
+}
+
+QString HistoryStore::recentJson(int before, int max, const QString &filter) const {
+    int cursor = before < 0 || before > visitOrder.size() ? newestCursor() : before - 1;
+    QJsonArray array;
+    for (int id : recent(cursor, qBound(1, max, 1000), filter.trimmed())) {
+        const HistoryEntry &e = entries.at(id);
+        array.append(QJsonObject{{"url", e.url}, {"title", e.title}, {"visits", int(e.visits)}, {"lastVisit", e.lastVisit}});
+    }
+    const QJsonObject page{{"entries", array}, {"before", cursor + 1}};
+    return QString::fromUtf8(QJsonDocument(page).toJson(QJsonDocument::Compact));
+}
+
+void HistoryStore::rebuildOrder() {
+    QVector<int> ids(entries.size());
+    for (int i = 0; i < ids.size(); ++i) ids[i] = i;
+    std::sort(ids.begin(), ids.end(), [this](int a, int b) {
+        return entries.at(a).lastVisit < entries.at(b).lastVisit;
+    });
+    visitOrder = ids;
+    for (int seq = 0; seq < visitOrder.size(); ++seq) entries[visitOrder.at(seq)].lastSeq = seq;
+    emit orderChanged();
+}
+
+void HistoryStore::compact() {
+    compacting = true;
+    compactionCancelled = false;
+    pending.clear();
+
+    QVector<HistoryEntry> snapshot = entries;
+    const QString target = path + ".compact";
+    QThreadPool::globalInstance()->start([this, snapshot, target]() mutable {
+        std::sort(snapshot.begin(), snapshot.end(), [](const HistoryEntry &a, const HistoryEntry &b) {
+            return a.lastVisit < b.lastVisit;
+        });
+        QFile f(target);
+        bool ok = f.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        if (ok) {
+            QDataStream out(&f);
+            out.setVersion(QDataStream::Qt_6_0);
+            for (const HistoryEntry &e : std::as_const(snapshot)) writeRecord(out, e);
+            ok = out.status() == QDataStream::Ok && f.flush();
+            f.close();
+        }
+        const int written = snapshot.size();
+        QMetaObject::invokeMethod(this, [this, ok, written]() { finishCompaction(ok, written); },
+                                  Qt::QueuedConnection);
+    });
+}
+
+void HistoryStore::finishCompaction(bool ok, int written) {
+    compacting = false;
+    const QString compacted = path + ".compact";
+    if (!ok || compactionCancelled) {
+        QFile::remove(compacted);
+        pending.clear();
+        return;
+    }
+
+    log.close();
+    QFile::remove(path);
+    QFile::rename(compacted, path);
+    openLog();
+
+    // Visits that landed while the pool thread was writing.
+    QDataStream out(&log);
+    out.setVersion(QDataStream::Qt_6_0);
+    for (const HistoryEntry &e : std::as_const(pending)) writeRecord(out, e);
+    log.flush();
+    logRecords = written + pending.size();
+    pending.clear();
+}
+
+void HistoryStore::clear() {
+    entries.clear();
+    index.clear();
+    visitOrder.clear();
+    pending.clear();
+    if (compacting) compactionCancelled = true;
+
+    if (log.isOpen()) {
+        log.close();
+        log.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        log.close();
+        openLog();
+    }
+    logRecords = 0;
+    emit cleared();
+    emit orderChanged();
+}
@@ -0,0 +1,75 @@
+#ifndef HISTORYSTORE_H
+#define HISTORYSTORE_H
+
+#include <QObject>
+#include <QFile>
+#include <QHash>
+#include <QVector>
+#include <QUrl>
+
+struct HistoryEntry {
+    QString url;
+    QString title;
+    qint64 lastVisit = 0;
+    quint32 visits = 0;
+    int lastSeq = -1;
+};
+
+// Browsing history backed by an append-only log in user_data/ (kept in memory
+// only when the path is empty, for off-the-record profiles). Every visit
+// appends the entry's new state to the log and updates an in-memory hash
+// index keyed by normalized URL; once the log holds mostly superseded
+// records it is rewritten on a pool thread.
+class HistoryStore : public QObject {
+    Q_OBJECT
+public:
+    explicit HistoryStore(const QString &path, QObject *parent = nullptr);
+    ~HistoryStore();
+
+    static QString normalize(const QUrl &url);
+
+    int addVisit(const QUrl &url, const QString &title);
+    int lookup(const QUrl &url) const { return index.value(normalize(url), -1); }
+    const HistoryEntry &entry(int id) const { return entries.at(id); }
+    int count() const { return entries.size(); }
+    QVector<HistoryEntry> snapshot() const { return entries; }
+    void clear();
+
+    // Walks visits newest first starting at cursor (-1 once exhausted). With
+    // a filter, only entries whose title or URL contain it are returned and at
+    // most scanLimit positions are walked per call.
+    QList<int> recent(int &cursor, int max, const QString &filter = QString(), int scanLimit = 5000) const;
+    int newestCursor() const { return visitOrder.size() - 1; }
+    // One page of recent(), for capture://history: {"entries": [...], "before": n}.
+    // Pass before = -1 for the newest page and the returned "before" for the
+    // next one; 0 means there is nothing older. Cursors stay valid until
+    // orderChanged.
+    Q_INVOKABLE QString recentJson(int before, int max, const QString &filter = QString()) const;
+
+signals:
+    void entryAdded(int id);
+    void entryUpdated(int id);
+    void orderChanged();
+    void cleared();
+
+private:
+    QString path;
+    QFile log;
+    QVector<HistoryEntry> entries;
+    QHash<QString, int> index;
+    QVector<int> visitOrder;
+    int logRecords = 0;
+    bool compacting = false;
+    bool compactionCancelled = false;
+    QList<HistoryEntry> pending;
+
+    void load();
+    void openLog();
+    void append(const HistoryEntry &e);
+    void upsert(const HistoryEntry &e);
+    void rebuildOrder();
+    void compact();
+    void finishCompaction(bool ok, int written);
+};
+
+#endif
@@ -0,0 +1,203 @@
+#include "litemode.h"
+#include "contentblocker.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QWebEngineNavigationRequest>
+#include <QWebEnginePage>
+#include <QWebEngineScript>
+#include <QWebEngineScriptCollection>
+
+static const char *const ScriptName = "capture-lite";
+
+// Median transfer sizes per request type, rounded; used only to put a byte
+// figure on requests that never happened.
+static qint64 typicalBytes(QWebEngineUrlRequestInfo::ResourceType type) {
+    switch (type) {
+    case QWebEngineUrlRequestInfo::ResourceTypeFontResource: return 30 * 1024;
+    case QWebEngineUrlRequestInfo::ResourceTypeScript: return 20 * 1024;
+    case QWebEngineUrlRequestInfo::ResourceTypePrefetch: return 15 * 1024;
+    case QWebEngineUrlRequestInfo::ResourceTypeImage: return 25 * 1024;
+    case QWebEngineUrlRequestInfo::ResourceTypeMedia: return 512 * 1024;
+    default: return 0;
+    }
+}
+
+LiteMode::LiteMode(const QString &path, QObject *parent)
+    : QWebEngineUrlRequestInterceptor(parent), path(path), sites(std::make_shared<const QSet<QByteArray>>()) {
+    load();
+    // Counters move on whatever thread the interceptor runs on; they are
+    // written out from here on a relaxed schedule instead.
+    saveTimer.setInterval(10 * 1000);
+    connect(&saveTimer, &QTimer::timeout, this, [this]() { if (dirty.exchange(false)) save(); });
+    saveTimer.start();
+    connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() { if (dirty.exchange(false)) save(); });
+}
+
+LiteMode::~LiteMode() {
+    if (dirty.exchange(false)) save();
+}
+
+QByteArray LiteMode::siteKey(const QString &hostOrUrl) {
+    const QString host = hostOrUrl.contains("://") ? QUrl(hostOrUrl).host() : QUrl::fromUserInput(hostOrUrl).host();
+    return ContentBlocker::siteOf(QUrl::toAce(host.toLower()));
+}
+
+bool LiteMode::isLite(const QUrl &url) const {
+    if (url.host().isEmpty()) return false;
+    std::shared_ptr<const QSet<QByteArray>> s = std::atomic_load(&sites);
+    return s->contains(ContentBlocker::siteOf(url.host(QUrl::FullyEncoded).toLatin1()));
+}
+
+void LiteMode::interceptRequest(QWebEngineUrlRequestInfo &info) {
+    const QWebEngineUrlRequestInfo::ResourceType type = info.resourceType();
+    if (type == QWebEngineUrlRequestInfo::ResourceTypeMainFrame) return;
+    std::shared_ptr<const QSet<QByteArray>> s = std::atomic_load(&sites);
+    if (s->isEmpty()) return;
+
+    const QByteArray site = ContentBlocker::siteOf(info.firstPartyUrl().host(QUrl::FullyEncoded).toLatin1());
+    if (!s->contains(site)) return;
+
+    bool refuse = false;
+    switch (type) {
+    case QWebEngineUrlRequestInfo::ResourceTypeFontResource:
+    case QWebEngineUrlRequestInfo::ResourceTypePrefetch:
+    case QWebEngineUrlRequestInfo::ResourceTypePing:
+    case QWebEngineUrlRequestInfo::ResourceTypeMedia:
+        refuse = true;
+        break;
+    case QWebEngineUrlRequestInfo::ResourceTypeScript:
+    case QWebEngineUrlRequestInfo::ResourceTypeImage:
+        refuse = ContentBlocker::siteOf(info.requestUrl().host(QUrl::FullyEncoded).toLatin1()) != site;
+        break;
+    default:
+        break;
+    }
+    if (!refuse) return;
+
+    info.block(true);
+    QMutexLocker lock(&savingsLock);
+    Savings &saved = savings[site];
+    saved.requests++;
+    saved.bytes += typicalBytes(type);
+    dirty = true;
+}
+
+void LiteMode::watch(QWebEnginePage *page) {
+    connect(page, &QWebEnginePage::navigationRequested, this, [this, page](QWebEngineNavigationRequest &request) {
+        if (request.isMainFrame()) apply(page, request.url());
+    });
+    apply(page, page->url());
+}
+
+void LiteMode::apply(QWebEnginePage *page, const QUrl &url) {
+    const bool on = isLite(url);
+    QWebEngineScriptCollection &scripts = page->scripts();
+    const QList<QWebEngineScript> existing = scripts.find(ScriptName);
+    if (!on) {
+        for (const QWebEngineScript &script : existing) scripts.remove(script);
+        return;
+    }
+    if (!existing.isEmpty()) return;
+
+    // Byte size is unknown until an image has been fetched, so the width cap
+    // is applied before that: parser-inserted images become lazy and lose
+    // srcset candidates above the cap as they arrive.
+    QWebEngineScript script;
+    script.setName(ScriptName);
+    script.setInjectionPoint(QWebEngineScript::DocumentCreation);
+    script.setWorldId(QWebEngineScript::ApplicationWorld);
+    script.setRunsOnSubFrames(true);
+    script.setSourceCode(QString(
+        "(function () {"
+        "  var cap = %1;"
+        "  function trim(set) {"
+        "    var all = set.split(/,\\s+/).map(function (c) {"
+        "      var p = c.trim().split(/\\s+/); return { url: p[0], d: p[1] || '1x' }; });"
+        "    var keep = all.filter(function (c) {"
+        "      var n = parseFloat(c.d); return /w$/.test(c.d) ? n <= cap : n <= 1; });"
+        "    if (!keep.length) keep = [all.sort(function (a, b) { return parseFloat(a.d) - parseFloat(b.d); })[0]];"
+        "    return keep.map(function (c) { return c.url + ' ' + c.d; }).join(', ');"
+        "  }"
+        "  function visit(el) {"
+        "    if (el.tagName === 'IMG') el.loading = 'lazy';"
+        "    var set = el.getAttribute('srcset');"
+        "    if (set) el.setAttribute('srcset', trim(set));"
+        "  }"
+        "  new MutationObserver(function (records) {"
+        "    records.forEach(function (r) { r.addedNodes.forEach(function (n) {"
+        "      if (n.nodeType !== 1) return;"
+        "      if (n.tagName === 'IMG' || n.tagName === 'SOURCE') visit(n);"
+        "      n.querySelectorAll('img, source').forEach(visit); }); });"
+        "  }).observe(document, { childList: true, subtree: true });"
+        "})()").arg(imageWidthCap));
+    scripts.insert(script);
+}
+
+void LiteMode::setLite(const QString &site, bool on) {
+    const QByteArray key = siteKey(site);
+    if (key.isEmpty()) return;
+    auto next = std::make_shared<QSet<QByteArray>>(*std::atomic_load(&sites));
+    if (on == next->contains(key)) return;
+    if (on) next->insert(key);
+    else next->remove(key);
+    std::atomic_store(&sites, std::shared_ptr<const QSet<QByteArray>>(next));
+    save();
+    emit changed();
+}
+
+void LiteMode::resetSavings() {
+    {
+        QMutexLocker lock(&savingsLock);
+        savings.clear();
+    }
+    save();
+    emit changed();
+}
+
+QString LiteMode::sitesJson() const {
+    std::shared_ptr<const QSet<QByteArray>> s = std::atomic_load(&sites);
+    QHash<QByteArray, Savings> saved;
+    {
+        QMutexLocker lock(&savingsLock);
+        saved = savings;
+    }
+    QSet<QByteArray> all = *s;
+    for (auto it = saved.cbegin(); it != saved.cend(); ++it) all.insert(it.key());
+
+    QJsonArray array;
+    for (const QByteArray &site : std::as_const(all)) {
+        const Savings entry = saved.value(site);
+        array.append(QJsonObject{{"site", QString::fromLatin1(site)}, {"lite", s->contains(site)},
+                                 {"requests", entry.requests}, {"bytes", entry.bytes}});
+    }
+    return QString::fromUtf8(QJsonDocument(array).toJson(QJsonDocument::Compact));
+}
+
+void LiteMode::load() {
+    if (path.isEmpty()) return;
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return;
+
+    auto loaded = std::make_shared<QSet<QByteArray>>();
+    const QJsonArray array = QJsonDocument::fromJson(f.readAll()).array();
+    for (const QJsonValue &v : array) {
+        const QJsonObject o = v.toObject();
+        const QByteArray site = o["site"].toString().toLatin1();
+        if (o["lite"].toBool()) loaded->insert(site);
+        savings.insert(site, {qint64(o["requests"].toDouble()), qint64(o["bytes"].toDouble())});
+    }
+    sites = loaded;
+}
+
+void LiteMode::save() {
+    if (path.isEmpty()) return;
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) return;
+    f.write(sitesJson().toUtf8());
+    f.commit();
+}
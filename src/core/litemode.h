@@ -0,0 +1,60 @@
+#ifndef LITEMODE_H
+#define LITEMODE_H
+
+#include <QWebEngineUrlRequestInterceptor>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QTimer>
+#include <QUrl>
+#include <atomic>
+#include <memory>
+
+class QWebEnginePage;
+
+// Per-site data saver. On sites switched to Lite, web fonts, audio and video,
+// third-party scripts and images, prefetches and pings are refused at the
+// network layer; first-party images load lazily with srcset candidates wider
+// than the cap dropped. Refused requests are tallied per site; their bytes are
+// estimated from typical transfer sizes, as a blocked response never reports
+// its own. Chained behind the ContentBlocker, so it runs on the same thread.
+class LiteMode : public QWebEngineUrlRequestInterceptor {
+    Q_OBJECT
+public:
+    explicit LiteMode(const QString &path, QObject *parent = nullptr);
+    ~LiteMode();
+
+    void interceptRequest(QWebEngineUrlRequestInfo &info) override;
+
+    // Applies the per-page side (the image script) on every main-frame navigation.
+    void watch(QWebEnginePage *page);
+    bool isLite(const QUrl &url) const;
+
+    Q_INVOKABLE void setLite(const QString &site, bool on);
+    Q_INVOKABLE QString sitesJson() const;
+    Q_INVOKABLE void resetSavings();
+
+signals:
+    void changed();
+
+private:
+    struct Savings {
+        qint64 requests = 0;
+        qint64 bytes = 0;
+    };
+
+    QString path;
+    std::shared_ptr<const QSet<QByteArray>> sites;
+    mutable QMutex savingsLock;
+    QHash<QByteArray, Savings> savings;
+    std::atomic_bool dirty{false};
+    QTimer saveTimer;
+    int imageWidthCap = 800;
+
+    static QByteArray siteKey(const QString &hostOrUrl);
+    void apply(QWebEnginePage *page, const QUrl &url);
+    void load();
+    void save();
+};
+
+#endif
@@ -0,0 +1,236 @@
+#include "omnibox.h"
+#include "contentindex.h"
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <QThreadPool>
+#include <algorithm>
+
+static const int CandidateBudget = 20000;
+
+static QStringView stripScheme(const QString &url) {
+    QStringView rest(url);
+    const int sep = url.indexOf("://");
+    if (sep != -1) rest = rest.mid(sep + 3);
+    if (rest.startsWith(QLatin1String("www."))) rest = rest.mid(4);
+    return rest;
+}
+
+static double frecency(const HistoryEntry &e, qint64 now) {
+    const double ageDays = double(now - e.lastVisit) / 86400000.0;
+    return e.visits / (1.0 + ageDays / 7.0);
+}
+
+SuggestionIndex::SuggestionIndex(HistoryStore *history, QObject *parent)
+    : QObject(parent), history(history) {
+    connect(history, &HistoryStore::entryAdded, this, &SuggestionIndex::addEntry);
+    connect(history, &HistoryStore::entryUpdated, this, &SuggestionIndex::addEntry);
+    connect(history, &HistoryStore::cleared, this, &SuggestionIndex::reset);
+    rebuild();
+}
+
+SuggestionIndex::~SuggestionIndex() {
+    if (building) QThreadPool::globalInstance()->waitForDone();
+}
+
+QStringList SuggestionIndex::tokenize(const QString &text) {
+    QStringList words;
+    QString word;
+    for (QChar c : text) {
+        if (c.isLetterOrNumber()) {
+            word.append(c.toLower());
+        } else if (!word.isEmpty()) {
+            words.append(word);
+            word.clear();
+        }
+    }
+    if (!word.isEmpty()) words.append(word);
+    return words;
+}
+
+void SuggestionIndex::indexEntry(TokenIndex &index, int id, const HistoryEntry &e) {
+    if (id >= index.stamps.size()) {
+        index.stamps.resize(id + 1, 0);
+        index.hitCount.resize(id + 1, 0);
+    }
+    // The entry's previous hits, including tokens of a replaced title, go stale.
+    index.staleHits += index.hitCount.at(id);
+    index.liveHits -= index.hitCount.at(id);
+    const quint32 stamp = index.nextStamp++;
+    index.stamps[id] = stamp;
+
+    QSet<QString> seen;
+    const QStringList words = tokenize(stripScheme(e.url).toString()) + tokenize(e.title);
+    for (const QString &w : words) {
+        if (seen.contains(w)) continue;
+        seen.insert(w);
+        index.postings[w].append({id, stamp});
+    }
+    index.hitCount[id] = seen.size();
+    index.liveHits += seen.size();
+}
+
+// Entries are indexed oldest visit first so posting order matches recency.
+void SuggestionIndex::rebuild() {
+    building = true;
+    pendingIds.clear();
+    const int gen = generation;
+    const QVector<HistoryEntry> snapshot = history->snapshot();
+    QThreadPool::globalInstance()->start([this, snapshot, gen]() {
+        QVector<int> order(snapshot.size());
+        for (int id = 0; id < order.size(); ++id) order[id] = id;
+        std::stable_sort(order.begin(), order.end(), [&snapshot](int a, int b) {
+            return snapshot.at(a).lastVisit < snapshot.at(b).lastVisit;
+        });
+        auto built = std::make_shared<TokenIndex>();
+        for (int id : std::as_const(order)) indexEntry(*built, id, snapshot.at(id));
+        QMetaObject::invokeMethod(this, [this, built, gen]() {
+            if (gen != generation) return;
+            tokens = built;
+            building = false;
+            for (int id : std::as_const(pendingIds)) addEntry(id);
+            pendingIds.clear();
+        }, Qt::QueuedConnection);
+    });
+}
+
+void SuggestionIndex::reset() {
+    generation++;
+    building = false;
+    pendingIds.clear();
+    tokens = std::make_shared<TokenIndex>();
+}
+
+void SuggestionIndex::addEntry(int id) {
+    if (building) {
+        pendingIds.append(id);
+        return;
+    }
+    if (!tokens) return;
+    indexEntry(*tokens, id, history->entry(id));
+    if (tokens->staleHits > tokens->liveHits + 4096) rebuild();
+}
+
+QList<int> SuggestionIndex::query(const QString &text, int max, QList<double> *scores) const {
+    if (!tokens) return {};
+    const QStringList words = tokenize(text);
+    if (words.isEmpty()) return {};
+
+    QString anchor;
+    for (const QString &w : words) if (w.size() > anchor.size()) anchor = w;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QSet<int> seen;
+    QVector<QPair<double, int>> scored;
+    int budget = CandidateBudget;
+
+    for (auto it = tokens->postings.lower_bound(anchor);
+         it != tokens->postings.end() && it->first.startsWith(anchor) && budget > 0; ++it) {
+        const QVector<TokenIndex::Hit> &hits = it->second;
+        // Most recently visited first, so the budget cuts off the stalest
+        // candidates; stale hits are skipped without counting against it.
+        for (auto p = hits.crbegin(); p != hits.crend() && budget > 0; ++p) {
+            const int id = p->id;
+            if (p->stamp != tokens->stamps.at(id) || id >= history->count() || seen.contains(id)) continue;
+            seen.insert(id);
+            --budget;
+
+            const HistoryEntry &e = history->entry(id);
+            bool matches = true;
+            for (const QString &w : words) {
+                if (w == anchor) continue;
+                if (!e.url.contains(w, Qt::CaseInsensitive) && !e.title.contains(w, Qt::CaseInsensitive)) {
+                    matches = false;
+                    break;
+                }
+            }
+            if (!matches) continue;
+
+            double score = frecency(e, now);
+            if (stripScheme(e.url).startsWith(anchor, Qt::CaseInsensitive)) score *= 4;
+            scored.append(qMakePair(score, id));
+        }
+    }
+
+    const int n = qMin(max, int(scored.size()));
+    std::partial_sort(scored.begin(), scored.begin() + n, scored.end(),
+                      [](const QPair<double, int> &a, const QPair<double, int> &b) { return a.first > b.first; });
+    QList<int> result;
+    for (int i = 0; i < n; ++i) {
+        result.append(scored.at(i).second);
+        if (scores) scores->append(scored.at(i).first);
+    }
+    return result;
+}
+
+SuggestionModel::SuggestionModel(SuggestionIndex *index, QObject *parent)
+    : QAbstractListModel(parent), index(index) {}
+
+void SuggestionModel::setContentIndex(ContentIndex *index) {
+    content = index;
+    connect(content, &ContentIndex::results, this, &SuggestionModel::addPages);
+}
+
+int SuggestionModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : ids.size() + pages.size();
+}
+
+QVariant SuggestionModel::data(const QModelIndex &idx, int role) const {
+    if (!idx.isValid() || idx.row() >= rowCount()) return QVariant();
+    if (idx.row() >= ids.size()) {
+        const PageHit &hit = pages.at(idx.row() - ids.size());
+        if (role == Qt::DisplayRole) return hit.label;
+        if (role == Qt::EditRole) return hit.url;
+        return QVariant();
+    }
+    if (ids.at(idx.row()) >= index->store()->count()) return QVariant();
+    const HistoryEntry &e = index->store()->entry(ids.at(idx.row()));
+    switch (role) {
+    case Qt::DisplayRole:
+        return e.title.isEmpty() ? e.url : e.title + "  -  " + e.url;
+    case Qt::EditRole:
+        return e.url;
+    default:
+        return QVariant();
+    }
+}
+
+void SuggestionModel::setQuery(const QString &text) {
+    beginResetModel();
+    query = text;
+    ids = index->query(text, 8);
+    pages.clear();
+    endResetModel();
+    if (content && text.trimmed().size() >= 3) content->search(text, 8);
+}
+
+// Page-text matches arrive after the history rows are already showing; the
+// ones for an outdated query, or for a URL already listed, are dropped.
+void SuggestionModel::addPages(const QString &text, const QString &json) {
+    if (text != query) return;
+    QSet<QString> listed;
+    for (int id : std::as_const(ids)) {
+        if (id < index->store()->count()) listed.insert(HistoryStore::normalize(QUrl(index->store()->entry(id).url)));
+    }
+
+    QList<PageHit> hits;
+    const QJsonArray array = QJsonDocument::fromJson(json.toUtf8()).array();
+    for (const QJsonValue &v : array) {
+        const QJsonObject o = v.toObject();
+        const QString url = o["url"].toString();
+        const QString key = HistoryStore::normalize(QUrl(url));
+        if (listed.contains(key)) continue;
+        listed.insert(key);
+        const QString title = o["title"].toString();
+        hits.append({url, (title.isEmpty() ? url : title) + "  -  " + o["snippet"].toString().left(80)});
+        if (hits.size() == 3) break;
+    }
+    if (hits.isEmpty()) return;
+
+    const int first = rowCount();
+    beginInsertRows(QModelIndex(), first, first + hits.size() - 1);
+    pages = hits;
+    endInsertRows();
+}
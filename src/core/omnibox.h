@@ -0,0 +1,90 @@
+#ifndef OMNIBOX_H
+#define OMNIBOX_H
+
+#include <QObject>
+#include <QAbstractListModel>
+#include <QVector>
+#include <map>
+#include <memory>
+#include "historystore.h"
+
+class ContentIndex;
+
+// Every visit re-appends an entry under all of its current tokens with a new
+// stamp, so each posting list runs from least to most recently visited and
+// hits under an outdated stamp (an earlier visit, or a title since changed)
+// are skipped. Once stale hits outnumber live ones the index is rebuilt.
+struct TokenIndex {
+    struct Hit {
+        int id;
+        quint32 stamp;
+    };
+    std::map<QString, QVector<Hit>> postings;
+    QVector<quint32> stamps;
+    QVector<int> hitCount;
+    quint32 nextStamp = 1;
+    qint64 liveHits = 0;
+    qint64 staleHits = 0;
+};
+
+// Word-prefix index over history URLs and titles. Lookups walk the ordered
+// token map from the query's longest word, verify the remaining words and
+// rank a bounded candidate set by frecency. The initial build runs on a pool
+// thread; afterwards every history insert is indexed incrementally.
+class SuggestionIndex : public QObject {
+    Q_OBJECT
+public:
+    explicit SuggestionIndex(HistoryStore *history, QObject *parent = nullptr);
+    ~SuggestionIndex();
+
+    QList<int> query(const QString &text, int max, QList<double> *scores = nullptr) const;
+    HistoryStore *store() const { return history; }
+
+    static QStringList tokenize(const QString &text);
+
+private slots:
+    void addEntry(int id);
+    void rebuild();
+    void reset();
+
+private:
+    HistoryStore *history;
+    std::shared_ptr<TokenIndex> tokens;
+    QList<int> pendingIds;
+    bool building = false;
+    int generation = 0;
+
+    static void indexEntry(TokenIndex &index, int id, const HistoryEntry &e);
+};
+
+// History matches for the address bar, followed by a few pages whose text
+// mentions the query once the content index answers.
+class SuggestionModel : public QAbstractListModel {
+    Q_OBJECT
+public:
+    explicit SuggestionModel(SuggestionIndex *index, QObject *parent = nullptr);
+
+    void setContentIndex(ContentIndex *content);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+public slots:
+    void setQuery(const QString &text);
+
+private:
+    struct PageHit {
+        QString url;
+        QString label;
+    };
+
+    SuggestionIndex *index;
+    ContentIndex *content = nullptr;
+    QList<int> ids;
+    QList<PageHit> pages;
+    QString query;
+
+    void addPages(const QString &text, const QString &json);
+};
+
+#endif
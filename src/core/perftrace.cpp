@@ -0,0 +1,201 @@
+#include "perftrace.h"
+#include "prerender.h"
+#include "processmemory.h"
+#include "startupconfig.h"
+#include "userdata.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QJsonDocument>
+#include <QMap>
+#include <QSaveFile>
+
+static const int MaxEvents = 20000;
+static const int MaxLoads = 500;
+
+PerfTracer *PerfTracer::instance() {
+    static PerfTracer *tracer = new PerfTracer(qApp);
+    return tracer;
+}
+
+PerfTracer::PerfTracer(QObject *parent) : QObject(parent) {
+    clock.start();
+}
+
+void PerfTracer::track(QWebEngineView *view) {
+    Tab tab;
+    tab.id = nextTab++;
+    tab.view = view;
+    tabs.insert(view, tab);
+    byId.insert(tab.id, view);
+    record(tab.id, "createNewTab", 'i', now());
+
+    connect(view, &QWebEngineView::loadStarted, this, [this, view]() {
+        Tab &tab = tabs[view];
+        // A new navigation before the previous one finished means it was abandoned.
+        if (tab.load.started >= 0) finishLoad(tab, false);
+        tab.load.tab = tab.id;
+        tab.load.url = view->url().toString();
+        tab.load.started = now();
+        record(tab.id, "loadStarted", 'i', tab.load.started, 0, {{"url", tab.load.url}});
+    });
+    connect(view, &QWebEngineView::urlChanged, this, [this, view](const QUrl &url) {
+        Tab &tab = tabs[view];
+        if (tab.load.started >= 0) tab.load.url = url.toString();
+        record(tab.id, "urlChanged", 'i', now(), 0, {{"url", url.toString()}});
+    });
+    connect(view, &QWebEngineView::loadProgress, this, [this, view](int progress) {
+        Tab &tab = tabs[view];
+        if (progress <= 0 || tab.load.started < 0 || tab.load.firstProgress >= 0) return;
+        tab.load.firstProgress = now();
+        record(tab.id, "firstProgress", 'i', tab.load.firstProgress, 0, {{"progress", progress}});
+    });
+    connect(view, &QWebEngineView::titleChanged, this, [this, view](const QString &title) {
+        Tab &tab = tabs[view];
+        if (title.isEmpty() || tab.load.started < 0 || tab.load.title >= 0) return;
+        tab.load.title = now();
+        record(tab.id, "title", 'i', tab.load.title);
+    });
+    connect(view, &QWebEngineView::loadFinished, this, [this, view](bool ok) {
+        finishLoad(tabs[view], ok);
+    });
+    connect(view, &QObject::destroyed, this, [this, view]() {
+        const int id = tabs.value(view).id;
+        record(id, "tabClosed", 'i', now());
+        byId.remove(id);
+        tabs.remove(view);
+    });
+}
+
+void PerfTracer::mark(QWebEngineView *view, const QString &name, const QJsonObject &args) {
+    auto it = tabs.find(view);
+    if (it != tabs.end()) record(it->id, name, 'i', now(), 0, args);
+}
+
+void PerfTracer::record(int tab, const QString &name, char phase, qint64 ts, qint64 dur, const QJsonObject &args) {
+    // Drop the oldest quarter at once so trimming stays amortised.
+    if (events.size() >= MaxEvents) events.remove(0, MaxEvents / 4);
+    events.append({name, phase, tab, ts, dur, args});
+}
+
+void PerfTracer::finishLoad(Tab &tab, bool ok) {
+    Load &load = tab.load;
+    if (load.started < 0) return;
+    load.finished = now();
+    load.ok = ok;
+    if (tab.view && tab.view->page()) {
+        load.pid = tab.view->page()->renderProcessPid();
+        load.rss = processResidentBytes(load.pid);
+    }
+
+    QJsonObject args = loadJson(load);
+    record(tab.id, "load", 'X', load.started, load.finished - load.started, args);
+    if (load.rss >= 0) {
+        record(tab.id, "rendererMemory", 'C', load.finished, 0,
+               {{QString("tab %1").arg(tab.id), double(load.rss) / (1024 * 1024)}});
+    }
+
+    if (loads.size() >= MaxLoads) loads.remove(0, MaxLoads / 4);
+    loads.append(load);
+    load = Load();
+}
+
+QJsonObject PerfTracer::loadJson(const Load &load) {
+    auto since = [&load](qint64 ts) { return ts < 0 ? QJsonValue() : QJsonValue((ts - load.started) / 1000.0); };
+    QJsonObject o;
+    o["tab"] = load.tab;
+    o["url"] = load.url;
+    o["ok"] = load.ok;
+    o["firstProgressMs"] = since(load.firstProgress);
+    o["titleMs"] = since(load.title);
+    o["loadMs"] = since(load.finished);
+    o["pid"] = load.pid;
+    o["rssMB"] = load.rss < 0 ? QJsonValue() : QJsonValue(double(load.rss) / (1024 * 1024));
+    return o;
+}
+
+QJsonObject PerfTracer::trace() const {
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray out;
+    out.append(QJsonObject{{"name", "process_name"}, {"ph", "M"}, {"pid", pid},
+                           {"args", QJsonObject{{"name", "Capture"}}}});
+    for (const Tab &tab : tabs) {
+        out.append(QJsonObject{{"name", "thread_name"}, {"ph", "M"}, {"pid", pid}, {"tid", tab.id},
+                               {"args", QJsonObject{{"name", QString("Tab %1").arg(tab.id)}}}});
+    }
+    for (const Event &e : events) {
+        QJsonObject o{{"name", e.name}, {"cat", "tab"}, {"ph", QString(QLatin1Char(e.phase))},
+                      {"ts", e.ts}, {"pid", pid}, {"tid", e.tab}};
+        if (e.phase == 'X') o["dur"] = e.dur;
+        if (e.phase == 'i') o["s"] = "t";
+        if (!e.args.isEmpty()) o["args"] = e.args;
+        out.append(o);
+    }
+    return QJsonObject{{"traceEvents", out}, {"displayTimeUnit", "ms"}};
+}
+
+// One entry per live renderer process with the tabs it hosts, so the effect
+// of the process model and process limit shows up directly.
+QJsonArray PerfTracer::renderers() const {
+    QMap<qint64, QJsonArray> hosted;
+    for (const Tab &tab : tabs) {
+        if (!tab.view) continue;
+        const qint64 pid = tab.view->page()->renderProcessPid();
+        if (pid > 0) hosted[pid].append(tab.id);
+    }
+    QJsonArray list;
+    for (auto it = hosted.cbegin(); it != hosted.cend(); ++it) {
+        const qint64 rss = processResidentBytes(it.key());
+        list.append(QJsonObject{{"pid", it.key()}, {"tabs", it.value()},
+                                {"rssMB", rss < 0 ? QJsonValue() : QJsonValue(double(rss) / (1024 * 1024))}});
+    }
+    return list;
+}
+
+void PerfTracer::addPrerenderer(Prerenderer *prerenderer) {
+    prerenderers.append(prerenderer);
+}
+
+QJsonObject PerfTracer::prerenderMetrics() const {
+    int predictions = 0, hits = 0, wasted = 0, active = 0;
+    double savedMs = 0;
+    for (const QPointer<Prerenderer> &p : prerenderers) {
+        if (!p) continue;
+        const QJsonObject m = p->metrics();
+        predictions += m["predictions"].toInt();
+        hits += m["hits"].toInt();
+        wasted += m["wasted"].toInt();
+        active += m["active"].toInt();
+        savedMs += m["savedMs"].toDouble();
+    }
+    return QJsonObject{{"predictions", predictions}, {"hits", hits}, {"wasted", wasted},
+                       {"hitRate", predictions ? double(hits) / predictions : 0.0},
+                       {"savedMs", savedMs}, {"active", active}};
+}
+
+QString PerfTracer::summary() const {
+    QJsonArray open;
+    for (const Tab &tab : tabs) {
+        if (!tab.view) continue;
+        const qint64 pid = tab.view->page()->renderProcessPid();
+        const qint64 rss = processResidentBytes(pid);
+        open.append(QJsonObject{{"tab", tab.id}, {"url", tab.view->url().toString()}, {"title", tab.view->title()},
+                                {"pid", pid}, {"rssMB", rss < 0 ? QJsonValue() : QJsonValue(double(rss) / (1024 * 1024))}});
+    }
+    QJsonArray recent;
+    for (int i = loads.size() - 1; i >= 0 && recent.size() < 100; --i) recent.append(loadJson(loads[i]));
+    return QString::fromUtf8(QJsonDocument(QJsonObject{{"tabs", open}, {"renderers", renderers()}, {"loads", recent},
+                                                       {"engine", StartupConfig::active().toJson()},
+                                                       {"prerender", prerenderMetrics()}})
+                             .toJson(QJsonDocument::Compact));
+}
+
+QString PerfTracer::exportTrace() {
+    const QString dir = userDataPath() + "/traces";
+    QDir().mkpath(dir);
+    const QString path = dir + "/trace-" + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".json";
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return QString();
+    file.write(QJsonDocument(trace()).toJson(QJsonDocument::Compact));
+    return file.commit() ? path : QString();
+}
@@ -0,0 +1,81 @@
+#ifndef PERFTRACE_H
+#define PERFTRACE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QPointer>
+#include <QVector>
+#include <QWebEngineView>
+
+class Prerenderer;
+
+// Timestamps each tab's lifecycle (creation, load start, URL change, first
+// progress, load finish, title) and samples its renderer PID and memory.
+// Kept in a bounded in-memory buffer, exported as Chrome trace-event JSON and
+// shown on capture://perf.
+class PerfTracer : public QObject {
+    Q_OBJECT
+public:
+    static PerfTracer *instance();
+
+    void track(QWebEngineView *view);
+    void mark(QWebEngineView *view, const QString &name, const QJsonObject &args = QJsonObject());
+    // Each window's address bar prerenderer; summary() adds up their hit rates.
+    void addPrerenderer(Prerenderer *prerenderer);
+
+    int tabId(QWebEngineView *view) const { return tabs.value(view).id; }
+    QWebEngineView *view(int id) const { return byId.value(id); }
+    bool isLoading(QWebEngineView *view) const { return tabs.value(view).load.started >= 0; }
+
+    Q_INVOKABLE QString summary() const;
+    QJsonArray renderers() const;
+    QJsonObject prerenderMetrics() const;
+    Q_INVOKABLE QString exportTrace();
+    QJsonObject trace() const;
+
+private:
+    struct Event {
+        QString name;
+        char phase;
+        int tab;
+        qint64 ts;
+        qint64 dur;
+        QJsonObject args;
+    };
+    struct Load {
+        int tab;
+        QString url;
+        qint64 started = -1;
+        qint64 firstProgress = -1;
+        qint64 title = -1;
+        qint64 finished = -1;
+        bool ok = false;
+        qint64 pid = 0;
+        qint64 rss = -1;
+    };
+    struct Tab {
+        int id = 0;
+        QPointer<QWebEngineView> view;
+        Load load;
+    };
+
+    explicit PerfTracer(QObject *parent);
+
+    QElapsedTimer clock;
+    QHash<QWebEngineView*, Tab> tabs;
+    QHash<int, QWebEngineView*> byId;
+    QVector<Event> events;
+    QVector<Load> loads;
+    QList<QPointer<Prerenderer>> prerenderers;
+    int nextTab = 1;
+
+    qint64 now() const { return clock.nsecsElapsed() / 1000; }
+    void record(int tab, const QString &name, char phase, qint64 ts, qint64 dur = 0, const QJsonObject &args = QJsonObject());
+    void finishLoad(Tab &tab, bool ok);
+    static QJsonObject loadJson(const Load &load);
+};
+
+#endif
@@ -0,0 +1,108 @@
+#include "prerender.h"
+#include "omnibox.h"
+#include "processmemory.h"
+
+Prerenderer::Prerenderer(SuggestionIndex *index, QWebEngineProfile *profile, QObject *parent)
+    : QObject(parent), index(index), profile(profile) {
+    debounce.setSingleShot(true);
+    debounce.setInterval(200);
+    connect(&debounce, &QTimer::timeout, this, [this]() {
+        if (typed.size() < 2) return;
+        QList<double> scores;
+        const QList<int> ids = this->index->query(typed, 4, &scores);
+        if (ids.isEmpty()) return;
+
+        double total = 0;
+        for (double s : std::as_const(scores)) total += s;
+        if (total <= 0 || scores.first() / total < threshold) return;
+        start(QUrl(this->index->store()->entry(ids.first()).url));
+    });
+}
+
+void Prerenderer::predict(const QString &text) {
+    typed = text.trimmed();
+    debounce.start();
+}
+
+int Prerenderer::find(QWebEnginePage *page) const {
+    for (int i = 0; i < prerenders.size(); ++i) {
+        if (prerenders.at(i).page == page) return i;
+    }
+    return -1;
+}
+
+void Prerenderer::start(const QUrl &url) {
+    const QString key = HistoryStore::normalize(url);
+    for (const Prerender &p : std::as_const(prerenders)) {
+        if (p.key == key) return;
+    }
+    while (!prerenders.isEmpty() && prerenders.size() >= maxConcurrent) discard(0);
+
+    Prerender p;
+    p.page = new QWebEnginePage(profile, this);
+    // Nobody can see or stop a prerender, so it must not make a sound.
+    p.page->setAudioMuted(true);
+    p.key = key;
+    p.started.start();
+    prerenders.append(p);
+    predictions++;
+
+    QWebEnginePage *page = p.page;
+    connect(page, &QWebEnginePage::loadFinished, this, [this, page](bool ok) {
+        const int i = find(page);
+        if (i == -1) return;
+        if (!ok || processResidentBytes(page->renderProcessPid()) > memoryCap) {
+            discard(i);
+            return;
+        }
+        prerenders[i].loadMs = prerenders.at(i).started.elapsed();
+    });
+    // A prediction nobody commits to is not worth keeping a renderer for.
+    QTimer::singleShot(30000, page, [this, page]() {
+        const int i = find(page);
+        if (i != -1) discard(i);
+    });
+    page->load(url);
+}
+
+void Prerenderer::discard(int i) {
+    Prerender p = prerenders.takeAt(i);
+    wasted++;
+    p.page->deleteLater();
+}
+
+void Prerenderer::cancelAll() {
+    debounce.stop();
+    while (!prerenders.isEmpty()) discard(0);
+}
+
+QWebEnginePage *Prerenderer::take(const QUrl &target, bool *loaded) {
+    debounce.stop();
+    const QString key = HistoryStore::normalize(target);
+    for (int i = 0; i < prerenders.size(); ++i) {
+        if (prerenders.at(i).key != key) continue;
+        Prerender p = prerenders.takeAt(i);
+        hits++;
+        // A finished prerender saved the whole load; one still in flight saved
+        // the time it has been running.
+        savedMs += p.loadMs >= 0 ? p.loadMs : p.started.elapsed();
+        if (loaded) *loaded = p.loadMs >= 0;
+        p.page->disconnect(this);
+        p.page->setParent(nullptr);
+        cancelAll();
+        return p.page;
+    }
+    cancelAll();
+    return nullptr;
+}
+
+QJsonObject Prerenderer::metrics() const {
+    QJsonObject m;
+    m["predictions"] = predictions;
+    m["hits"] = hits;
+    m["wasted"] = wasted;
+    m["hitRate"] = predictions ? double(hits) / predictions : 0.0;
+    m["savedMs"] = double(savedMs);
+    m["active"] = int(prerenders.size());
+    return m;
+}
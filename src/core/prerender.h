@@ -0,0 +1,60 @@
+#ifndef PRERENDER_H
+#define PRERENDER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QTimer>
+#include <QUrl>
+#include <QWebEnginePage>
+#include <QWebEngineProfile>
+
+class SuggestionIndex;
+
+// Warms the most likely address bar destination in a hidden QWebEnginePage
+// while the user is still typing. On commit the warmed page is handed over to
+// the current tab instead of starting a fresh load.
+class Prerenderer : public QObject {
+    Q_OBJECT
+public:
+    Prerenderer(SuggestionIndex *index, QWebEngineProfile *profile, QObject *parent = nullptr);
+
+    void setConfidenceThreshold(double share) { threshold = share; }
+    void setMaxConcurrent(int count) { maxConcurrent = count; }
+    void setMemoryCap(qint64 bytes) { memoryCap = bytes; }
+
+    QWebEnginePage *take(const QUrl &target, bool *loaded = nullptr);
+    void cancelAll();
+    QJsonObject metrics() const;
+
+public slots:
+    void predict(const QString &text);
+
+private:
+    struct Prerender {
+        QWebEnginePage *page;
+        QString key;
+        QElapsedTimer started;
+        qint64 loadMs = -1;
+    };
+
+    SuggestionIndex *index;
+    QWebEngineProfile *profile;
+    QTimer debounce;
+    QString typed;
+    QList<Prerender> prerenders;
+    double threshold = 0.5;
+    int maxConcurrent = 1;
+    qint64 memoryCap = 256ll * 1024 * 1024;
+
+    int predictions = 0;
+    int hits = 0;
+    int wasted = 0;
+    qint64 savedMs = 0;
+
+    void start(const QUrl &url);
+    void discard(int i);
+    int find(QWebEnginePage *page) const;
+};
+
+#endif
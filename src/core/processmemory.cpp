@@ -0,0 +1,33 @@
+#include "processmemory.h"
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+qint64 processResidentBytes(qint64 pid) {
+    if (pid <= 0) return -1;
+#if defined(Q_OS_WIN)
+    HANDLE h = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, DWORD(pid));
+    if (!h) return -1;
+    PROCESS_MEMORY_COUNTERS pmc;
+    qint64 rss = -1;
+    if (K32GetProcessMemoryInfo(h, &pmc, sizeof(pmc))) rss = qint64(pmc.WorkingSetSize);
+    CloseHandle(h);
+    return rss;
+#elif defined(Q_OS_LINUX)
+    QFile f(QString("/proc/%1/statm").arg(pid));
+    if (!f.open(QIODevice::ReadOnly)) return -1;
+    QList<QByteArray> fields = f.readAll().split(' ');
+    if (fields.size() < 2) return -1;
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
@@ -0,0 +1,9 @@
+#ifndef PROCESSMEMORY_H
+#define PROCESSMEMORY_H
+
+#include <QtGlobal>
+
+// Resident set size of a process in bytes, or -1 if it cannot be read.
+qint64 processResidentBytes(qint64 pid);
+
+#endif
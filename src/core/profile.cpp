@@ -0,0 +1,95 @@
+#include "profile.h"
+#include "userdata.h"
+#include "historystore.h"
+#include "omnibox.h"
+#include "contentblocker.h"
+#include "downloadmanager.h"
+#include "schemehandler.h"
+#include "thumbnailcache.h"
+#include "sitedecisions.h"
+#include "litemode.h"
+#include "contentindex.h"
+#include <QApplication>
+#include <QDir>
+#include <QWebEngineSettings>
+#include <QRegularExpression>
+
+QHash<QString, Profile*> Profile::registry;
+Profile *Profile::privateProfile = nullptr;
+
+Profile *Profile::open(const QString &name) {
+    QString key = name;
+    key.remove(QRegularExpression("[^A-Za-z0-9_-]"));
+    if (key.isEmpty()) key = "Default";
+    if (Profile *p = registry.value(key)) return p;
+
+    // The default profile keeps the original user_data/ layout so existing
+    // cookies and logins survive; named profiles get a directory of their own.
+    QString path = userDataPath();
+    if (key != "Default") path += "/profiles/" + key;
+    QDir().mkpath(path);
+
+    Profile *p = new Profile(key, path);
+    registry.insert(key, p);
+    return p;
+}
+
+Profile *Profile::offTheRecord() {
+    if (!privateProfile) privateProfile = new Profile("Private", QString());
+    return privateProfile;
+}
+
+// Named profiles live as long as the process. A private one goes with its
+// last window; the delete is deferred so that window's pages, which are
+// destroyed after it lets go, never outlive their QWebEngineProfile.
+void Profile::release() {
+    if (--users > 0 || !isOffTheRecord()) return;
+    if (privateProfile == this) privateProfile = nullptr;
+    deleteLater();
+}
+
+Profile::Profile(const QString &name, const QString &path)
+    : QObject(qApp), profileName(name), path(path) {
+    if (isOffTheRecord()) {
+        webProfile = new QWebEngineProfile(this);
+        webProfile->setHttpCacheType(QWebEngineProfile::MemoryHttpCache);
+    } else {
+        webProfile = new QWebEngineProfile(name, this);
+        webProfile->setPersistentStoragePath(path + "/storage");
+        webProfile->setCachePath(path + "/cache");
+        webProfile->setHttpCacheType(QWebEngineProfile::DiskHttpCache);
+        webProfile->setPersistentCookiesPolicy(QWebEngineProfile::ForcePersistentCookies);
+    }
+
+    QString ua = webProfile->httpUserAgent();
+    ua.replace("QtWebEngine/6.8.0 ", ""); 
+    webProfile->setHttpUserAgent(ua);
+
+    QWebEngineSettings *s = webProfile->settings();
+    s->setAttribute(QWebEngineSettings::LocalStorageEnabled, true);
+    s->setAttribute(QWebEngineSettings::JavascriptEnabled, true);
+
+    historyStore = new HistoryStore(isOffTheRecord() ? QString() : path + "/history.log", this);
+    suggestionIndex = new SuggestionIndex(historyStore, this);
+    contentIndex = new ContentIndex(isOffTheRecord() ? QString() : path + "/content", this);
+    connect(historyStore, &HistoryStore::cleared, contentIndex, &ContentIndex::clear);
+    contentBlocker = new ContentBlocker(userDataPath() + "/filters", this);
+    liteMode = new LiteMode(isOffTheRecord() ? QString() : path + "/lite.json", this);
+    contentBlocker->setNext(liteMode);
+    webProfile->setUrlRequestInterceptor(contentBlocker);
+    webProfile->installUrlSchemeHandler("capture", CaptureSchemeHandler::instance());
+    downloadManager = new DownloadManager(webProfile, isOffTheRecord() ? QString() : path + "/downloads.json", this);
+    thumbnailCache = new ThumbnailCache(isOffTheRecord() ? QString() : path + "/thumbnails", this);
+    connect(historyStore, &HistoryStore::cleared, thumbnailCache, &ThumbnailCache::clear);
+
+    // Permission answers live in SiteDecisions, which can also be cleared;
+    // Chromium's own store would otherwise answer before we are asked.
+    webProfile->setPersistentPermissionsPolicy(QWebEngineProfile::PersistentPermissionsPolicy::AskEveryTime);
+    siteDecisions = new SiteDecisions(isOffTheRecord() ? QString() : path + "/decisions.json", this);
+}
+
+bool Profile::claimSession() {
+    if (isOffTheRecord() || sessionClaimed) return false;
+    sessionClaimed = true;
+    return true;
+}
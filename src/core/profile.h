@@ -0,0 +1,71 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <QObject>
+#include <QHash>
+#include <QWebEngineProfile>
+
+class HistoryStore;
+class SuggestionIndex;
+class ContentBlocker;
+class DownloadManager;
+class ThumbnailCache;
+class SiteDecisions;
+class LiteMode;
+class ContentIndex;
+
+// A browsing workspace: one QWebEngineProfile plus everything persisted for
+// it (storage, cache, history, session), kept apart from every other profile.
+// Windows are bound to a profile for their whole lifetime.
+class Profile : public QObject {
+    Q_OBJECT
+public:
+    static Profile *open(const QString &name);
+    // The private profile shared by the open private windows, created when
+    // none exists. It is thrown away, with everything it holds, once the last
+    // user has released it.
+    static Profile *offTheRecord();
+
+    // Held by every window (and batch run) for as long as it uses the profile.
+    void retain() { users++; }
+    void release();
+
+    QWebEngineProfile *web() const { return webProfile; }
+    QString name() const { return profileName; }
+    QString dataPath() const { return path; }
+    bool isOffTheRecord() const { return path.isEmpty(); }
+
+    HistoryStore *history() const { return historyStore; }
+    SuggestionIndex *suggestions() const { return suggestionIndex; }
+    ContentBlocker *blocker() const { return contentBlocker; }
+    DownloadManager *downloads() const { return downloadManager; }
+    ThumbnailCache *thumbnails() const { return thumbnailCache; }
+    SiteDecisions *decisions() const { return siteDecisions; }
+    LiteMode *lite() const { return liteMode; }
+    ContentIndex *content() const { return contentIndex; }
+
+    // The session file belongs to the first window opened on the profile.
+    bool claimSession();
+
+private:
+    Profile(const QString &name, const QString &path);
+
+    QString profileName;
+    QString path;
+    QWebEngineProfile *webProfile;
+    HistoryStore *historyStore;
+    SuggestionIndex *suggestionIndex;
+    ContentBlocker *contentBlocker;
+    DownloadManager *downloadManager;
+    ThumbnailCache *thumbnailCache;
+    SiteDecisions *siteDecisions;
+    LiteMode *liteMode;
+    ContentIndex *contentIndex;
+    bool sessionClaimed = false;
+    int users = 0;
+
+    static QHash<QString, Profile*> registry;
+    static Profile *privateProfile;
+};
+
+#endif
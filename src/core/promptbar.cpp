@@ -0,0 +1,78 @@
+#include "promptbar.h"
+#include <QEvent>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QWebEngineView>
+
+PromptBar *PromptBar::forView(QWebEngineView *view) {
+    if (auto *bar = view->findChild<PromptBar*>(QString(), Qt::FindDirectChildrenOnly)) return bar;
+    return new PromptBar(view);
+}
+
+PromptBar::PromptBar(QWebEngineView *view) : QFrame(view), view(view) {
+    // Colours come from the window's theme palette.
+    setBackgroundRole(QPalette::AlternateBase);
+    setAutoFillBackground(true);
+
+    auto *layout = new QHBoxLayout(this);
+    layout->setContentsMargins(12, 6, 12, 6);
+    message = new QLabel;
+    message->setWordWrap(true);
+    acceptButton = new QPushButton;
+    rejectButton = new QPushButton;
+    auto *close = new QPushButton("x");
+    layout->addWidget(message, 1);
+    layout->addWidget(acceptButton);
+    layout->addWidget(rejectButton);
+    layout->addWidget(close);
+
+    connect(acceptButton, &QPushButton::clicked, this, [this]() { answer(Accepted); });
+    connect(rejectButton, &QPushButton::clicked, this, [this]() { answer(Rejected); });
+    connect(close, &QPushButton::clicked, this, [this]() { answer(Dismissed); });
+
+    view->installEventFilter(this);
+    hide();
+}
+
+void PromptBar::ask(const QString &key, const QString &text, const QString &accept, const QString &reject, Callback callback) {
+    for (Prompt &p : queue) {
+        if (p.key == key) {
+            p.callbacks.append(std::move(callback));
+            return;
+        }
+    }
+    queue.append({key, text, accept, reject, {std::move(callback)}});
+    if (queue.size() == 1) showNext();
+}
+
+void PromptBar::answer(Answer answer) {
+    if (queue.isEmpty()) return;
+    const Prompt prompt = queue.takeFirst();
+    for (const Callback &callback : prompt.callbacks) callback(answer);
+    showNext();
+}
+
+void PromptBar::showNext() {
+    if (queue.isEmpty()) {
+        hide();
+        return;
+    }
+    const Prompt &prompt = queue.first();
+    message->setText(prompt.text);
+    acceptButton->setText(prompt.accept);
+    rejectButton->setText(prompt.reject);
+    reposition();
+    show();
+    raise();
+}
+
+void PromptBar::reposition() {
+    const int height = hasHeightForWidth() ? heightForWidth(view->width()) : sizeHint().height();
+    setGeometry(0, 0, view->width(), height);
+}
+
+bool PromptBar::eventFilter(QObject *watched, QEvent *event) {
+    if (watched == view && event->type() == QEvent::Resize && isVisible()) reposition();
+    return QFrame::eventFilter(watched, event);
+}
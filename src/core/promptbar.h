@@ -0,0 +1,52 @@
+#ifndef PROMPTBAR_H
+#define PROMPTBAR_H
+
+#include <QFrame>
+#include <QList>
+#include <functional>
+
+class QLabel;
+class QPushButton;
+class QWebEngineView;
+
+// A strip across the top of one tab asking a yes/no question about the page
+// (a permission, a certificate error). Unlike a message box it blocks nothing:
+// the page, the other tabs and the rest of the window carry on while it waits,
+// and further questions for the same tab queue up behind it.
+class PromptBar : public QFrame {
+    Q_OBJECT
+public:
+    enum Answer { Accepted, Rejected, Dismissed };
+    using Callback = std::function<void(Answer)>;
+
+    static PromptBar *forView(QWebEngineView *view);
+
+    // Questions with the same key while one is pending share its answer.
+    void ask(const QString &key, const QString &text, const QString &accept, const QString &reject, Callback callback);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    explicit PromptBar(QWebEngineView *view);
+
+    struct Prompt {
+        QString key;
+        QString text;
+        QString accept;
+        QString reject;
+        QList<Callback> callbacks;
+    };
+
+    QWebEngineView *view;
+    QList<Prompt> queue;
+    QLabel *message;
+    QPushButton *acceptButton;
+    QPushButton *rejectButton;
+
+    void answer(Answer answer);
+    void showNext();
+    void reposition();
+};
+
+#endif
@@ -0,0 +1,351 @@
+#include "replayserver.h"
+#include "userdata.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkProxy>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QProcess>
+#include <QSaveFile>
+#include <QSslCertificate>
+#include <QSslKey>
+#include <QSslSocket>
+#include <QStandardPaths>
+#include <QTimer>
+
+static bool isHopByHop(const QByteArray &name) {
+    static const char *const names[] = {
+        "connection", "keep-alive", "proxy-connection", "proxy-authorization", "proxy-authenticate",
+        "transfer-encoding", "te", "trailer", "upgrade", "content-length"
+    };
+    for (const char *n : names) {
+        if (name.compare(n, Qt::CaseInsensitive) == 0) return true;
+    }
+    return false;
+}
+
+NetArchive::NetArchive(const QString &dir) : dir(dir), index(dir + "/index.jsonl") {}
+
+QByteArray NetArchive::requestKey(const QByteArray &method, const QUrl &url, const QByteArray &body) {
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(method);
+    hash.addData(" ");
+    hash.addData(url.toEncoded(QUrl::RemoveFragment));
+    hash.addData("\n");
+    hash.addData(QCryptographicHash::hash(body, QCryptographicHash::Sha256));
+    return hash.result().toHex();
+}
+
+bool NetArchive::load() {
+    QFile in(index.fileName());
+    if (!in.open(QIODevice::ReadOnly)) return false;
+    while (!in.atEnd()) {
+        const QJsonObject o = QJsonDocument::fromJson(in.readLine()).object();
+        if (o.isEmpty()) continue;
+        ArchivedResponse response;
+        response.status = o["status"].toInt();
+        response.reason = o["reason"].toString().toLatin1();
+        response.bodyHash = o["body"].toString().toLatin1();
+        for (const QJsonValue &h : o["headers"].toArray()) {
+            const QJsonArray pair = h.toArray();
+            response.headers.append({pair.at(0).toString().toLatin1(), pair.at(1).toString().toLatin1()});
+        }
+        entries[o["key"].toString().toLatin1()].append(response);
+    }
+    return true;
+}
+
+bool NetArchive::openForAppend() {
+    QDir().mkpath(dir + "/blobs");
+    load();
+    return index.open(QIODevice::WriteOnly | QIODevice::Append);
+}
+
+void NetArchive::append(const QByteArray &key, const QByteArray &method, const QUrl &url,
+                        const ArchivedResponse &response, const QByteArray &body) {
+    ArchivedResponse stored = response;
+    stored.bodyHash = QCryptographicHash::hash(body, QCryptographicHash::Sha256).toHex();
+    const QString blob = dir + "/blobs/" + QString::fromLatin1(stored.bodyHash);
+    if (!QFile::exists(blob)) {
+        QSaveFile f(blob);
+        if (f.open(QIODevice::WriteOnly)) {
+            f.write(body);
+            f.commit();
+        }
+    }
+
+    QJsonArray headers;
+    for (const auto &h : stored.headers) headers.append(QJsonArray{QString::fromLatin1(h.first), QString::fromLatin1(h.second)});
+    QJsonObject o;
+    o["key"] = QString::fromLatin1(key);
+    o["method"] = QString::fromLatin1(method);
+    o["url"] = url.toString();
+    o["status"] = stored.status;
+    o["reason"] = QString::fromLatin1(stored.reason);
+    o["headers"] = headers;
+    o["body"] = QString::fromLatin1(stored.bodyHash);
+    index.write(QJsonDocument(o).toJson(QJsonDocument::Compact) + '\n');
+    index.flush();
+    entries[key].append(stored);
+}
+
+bool NetArchive::find(const QByteArray &key, ArchivedResponse *response) {
+    const QList<ArchivedResponse> list = entries.value(key);
+    if (list.isEmpty()) return false;
+    int &next = served[key];
+    *response = list.at(qMin(next, int(list.size()) - 1));
+    next++;
+    return true;
+}
+
+QByteArray NetArchive::body(const QByteArray &hash) const {
+    if (hash.isEmpty()) return QByteArray();
+    QFile f(dir + "/blobs/" + QString::fromLatin1(hash));
+    return f.open(QIODevice::ReadOnly) ? f.readAll() : QByteArray();
+}
+
+ReplayServer::ReplayServer(Mode mode, const QString &archiveDir, QObject *parent)
+    : QTcpServer(parent), mode(mode), archive(archiveDir) {
+    // Upstream fetches while recording must never loop back into ourselves.
+    network.setProxy(QNetworkProxy::NoProxy);
+}
+
+// Each installation makes its own key pair rather than shipping one, with
+// the openssl tool since Qt cannot generate keys. Without it start() fails and
+// says where a certificate and key can be put by hand. Chromium ignores
+// certificate errors while it is pointed at the proxy, so self-signed is enough.
+bool ReplayServer::loadIdentity(QSslCertificate *cert, QSslKey *key) {
+    const QString dir = userDataPath() + "/replay";
+    const QString certPath = dir + "/cert.pem";
+    const QString keyPath = dir + "/key.pem";
+    if (!QFile::exists(certPath) || !QFile::exists(keyPath)) {
+        const QString tool = QStandardPaths::findExecutable("openssl");
+        if (tool.isEmpty()) {
+            error = QString("Record/replay needs a TLS certificate, but the openssl tool was not found. "
+                            "Install it, or put a PEM certificate and RSA key in %1 and %2.")
+                        .arg(QDir::toNativeSeparators(certPath), QDir::toNativeSeparators(keyPath));
+            return false;
+        }
+        QDir().mkpath(dir);
+        QProcess openssl;
+        openssl.start(tool, {"req", "-x509", "-newkey", "rsa:2048", "-nodes", "-days", "3650",
+                             "-subj", "/CN=Capture Replay", "-keyout", keyPath, "-out", certPath});
+        if (!openssl.waitForFinished(30000) || openssl.exitStatus() != QProcess::NormalExit || openssl.exitCode() != 0) {
+            error = QString("Cannot create the replay certificate in %1: %2")
+                        .arg(QDir::toNativeSeparators(dir), QString::fromLocal8Bit(openssl.readAllStandardError()).trimmed());
+            QFile::remove(certPath);
+            QFile::remove(keyPath);
+            return false;
+        }
+        QFile::setPermissions(keyPath, QFile::ReadOwner | QFile::WriteOwner);
+    }
+
+    QFile certFile(certPath);
+    QFile keyFile(keyPath);
+    if (certFile.open(QIODevice::ReadOnly) && keyFile.open(QIODevice::ReadOnly)) {
+        *cert = QSslCertificate(certFile.readAll());
+        *key = QSslKey(keyFile.readAll(), QSsl::Rsa);
+    }
+    if (cert->isNull() || key->isNull()) {
+        error = QString("Cannot read the replay certificate and key from %1").arg(QDir::toNativeSeparators(dir));
+        return false;
+    }
+    return true;
+}
+
+bool ReplayServer::start() {
+    if (mode == Replay ? !archive.load() : !archive.openForAppend()) {
+        error = QString("Cannot open archive %1").arg(QDir::toNativeSeparators(archive.path()));
+        return false;
+    }
+
+    QSslCertificate cert;
+    QSslKey key;
+    if (!loadIdentity(&cert, &key)) return false;
+    tls = QSslConfiguration::defaultConfiguration();
+    tls.setLocalCertificate(cert);
+    tls.setPrivateKey(key);
+    tls.setPeerVerifyMode(QSslSocket::VerifyNone);
+
+    if (!listen(QHostAddress::LocalHost, 0)) {
+        error = errorString();
+        return false;
+    }
+    return true;
+}
+
+QByteArray ReplayServer::chromiumFlags() const {
+    // The generated certificate is self-signed, so certificate checks are off
+    // for as long as Chromium talks to the proxy.
+    return "--proxy-server=http://127.0.0.1:" + QByteArray::number(serverPort()) + " --ignore-certificate-errors";
+}
+
+void ReplayServer::incomingConnection(qintptr handle) {
+    auto *socket = new QSslSocket(this);
+    if (!socket->setSocketDescriptor(handle)) {
+        delete socket;
+        return;
+    }
+    connections.insert(socket, Connection());
+    connect(socket, &QSslSocket::readyRead, this, [this, socket]() {
+        auto it = connections.find(socket);
+        if (it == connections.end()) return;
+        it->buffer += socket->readAll();
+        readRequests(socket);
+    });
+    connect(socket, &QSslSocket::disconnected, this, [this, socket]() {
+        connections.remove(socket);
+        socket->deleteLater();
+    });
+}
+
+// Parses as many complete requests as the buffer holds. Chromium never
+// pipelines through a proxy, so one request is in flight per connection.
+void ReplayServer::readRequests(QSslSocket *socket) {
+    auto it = connections.find(socket);
+    if (it == connections.end()) return;
+    Connection &c = *it;
+
+    while (!c.busy) {
+        const int end = c.buffer.indexOf("\r\n\r\n");
+        if (end < 0) return;
+        const QList<QByteArray> lines = c.buffer.left(end).split('\n');
+        const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+        if (requestLine.size() < 3) {
+            socket->disconnectFromHost();
+            return;
+        }
+
+        Request request;
+        request.method = requestLine.at(0);
+        qint64 length = 0;
+        for (int i = 1; i < lines.size(); ++i) {
+            const QByteArray line = lines.at(i).trimmed();
+            const int colon = line.indexOf(':');
+            if (colon <= 0) continue;
+            const QByteArray name = line.left(colon).trimmed();
+            const QByteArray value = line.mid(colon + 1).trimmed();
+            if (name.compare("content-length", Qt::CaseInsensitive) == 0) length = value.toLongLong();
+            request.headers.append({name, value});
+        }
+        if (c.buffer.size() < end + 4 + length) return;
+        request.body = c.buffer.mid(end + 4, length);
+        c.buffer.remove(0, end + 4 + length);
+
+        const QByteArray target = requestLine.at(1);
+        if (request.method == "CONNECT") {
+            c.tunnel = target;
+            socket->write("HTTP/1.1 200 Connection Established\r\n\r\n");
+            socket->flush();
+            socket->setSslConfiguration(tls);
+            socket->startServerEncryption();
+            continue;
+        }
+        if (!c.tunnel.isEmpty()) {
+            QByteArray host = c.tunnel;
+            if (host.endsWith(":443")) host.chop(4);
+            request.url = QUrl::fromEncoded("https://" + host + target);
+        } else {
+            request.url = QUrl::fromEncoded(target);
+        }
+        c.busy = true;
+        handle(socket, request);
+    }
+}
+
+void ReplayServer::handle(QSslSocket *socket, const Request &request) {
+    const QByteArray key = NetArchive::requestKey(request.method, request.url, request.body);
+    if (mode == Record) {
+        fetch(socket, request, key);
+        return;
+    }
+
+    ArchivedResponse response;
+    if (archive.find(key, &response)) {
+        respond(socket, response, archive.body(response.bodyHash));
+    } else {
+        qWarning("replay: %s %s is not in the archive", request.method.constData(), qPrintable(request.url.toString()));
+        response.status = 404;
+        response.reason = "Not Found";
+        respond(socket, response, QByteArray());
+    }
+}
+
+void ReplayServer::fetch(QSslSocket *socket, const Request &request, const QByteArray &key) {
+    QNetworkRequest upstream(request.url);
+    // Hand Chromium exactly what the server said: redirects, cookies and
+    // compressed bodies all pass through untouched.
+    upstream.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::ManualRedirectPolicy);
+    upstream.setAttribute(QNetworkRequest::CookieLoadControlAttribute, QNetworkRequest::Manual);
+    upstream.setAttribute(QNetworkRequest::CookieSaveControlAttribute, QNetworkRequest::Manual);
+    upstream.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+    for (const auto &h : request.headers) {
+        if (isHopByHop(h.first) || h.first.compare("host", Qt::CaseInsensitive) == 0) continue;
+        upstream.setRawHeader(h.first, h.second);
+    }
+
+    QNetworkReply *reply = network.sendCustomRequest(upstream, request.method, request.body);
+    QPointer<QSslSocket> target(socket);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, target, request, key]() {
+        reply->deleteLater();
+        ArchivedResponse response;
+        const QVariant status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+        const QByteArray body = reply->readAll();
+        if (!status.isValid()) {
+            response.status = 502;
+            response.reason = "Bad Gateway";
+            if (target) respond(target, response, reply->errorString().toUtf8());
+            return;
+        }
+
+        response.status = status.toInt();
+        response.reason = reply->attribute(QNetworkRequest::HttpReasonPhraseAttribute).toByteArray();
+        for (const auto &h : reply->rawHeaderPairs()) {
+            if (isHopByHop(h.first)) continue;
+            // Qt folds repeated headers such as Set-Cookie into one newline-separated value.
+            for (const QByteArray &value : h.second.split('\n')) response.headers.append({h.first, value});
+        }
+        archive.append(key, request.method, request.url, response, body);
+        if (target) respond(target, response, body);
+    });
+}
+
+void ReplayServer::respond(QSslSocket *socket, const ArchivedResponse &response, const QByteArray &body) {
+    QByteArray data = "HTTP/1.1 " + QByteArray::number(response.status) + ' ' + response.reason + "\r\n";
+    for (const auto &h : response.headers) data += h.first + ": " + h.second + "\r\n";
+    data += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    data += "Connection: keep-alive\r\n\r\n";
+    data += body;
+
+    if (latencyMs > 0) {
+        QTimer::singleShot(latencyMs, socket, [this, socket, data]() { send(socket, data, 0); });
+    } else {
+        send(socket, data, 0);
+    }
+}
+
+// Bandwidth shaping: write the response in 10 ms slices sized to the cap.
+void ReplayServer::send(QSslSocket *socket, const QByteArray &data, qint64 offset) {
+    if (bytesPerSecond <= 0) {
+        socket->write(data.mid(offset));
+        finishResponse(socket);
+        return;
+    }
+    const qint64 chunk = qMax<qint64>(1, bytesPerSecond / 100);
+    socket->write(data.mid(offset, chunk));
+    if (offset + chunk >= data.size()) {
+        finishResponse(socket);
+        return;
+    }
+    QTimer::singleShot(10, socket, [this, socket, data, offset, chunk]() { send(socket, data, offset + chunk); });
+}
+
+void ReplayServer::finishResponse(QSslSocket *socket) {
+    auto it = connections.find(socket);
+    if (it == connections.end()) return;
+    it->busy = false;
+    QTimer::singleShot(0, socket, [this, socket]() { readRequests(socket); });
+}
@@ -0,0 +1,104 @@
+#ifndef REPLAYSERVER_H
+#define REPLAYSERVER_H
+
+#include <QTcpServer>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QPair>
+#include <QSslConfiguration>
+#include <QUrl>
+
+class QSslCertificate;
+class QSslKey;
+class QSslSocket;
+
+struct ArchivedResponse {
+    int status = 200;
+    QByteArray reason;
+    QList<QPair<QByteArray, QByteArray>> headers;
+    QByteArray bodyHash;
+};
+
+// Recorded traffic on disk. Bodies are content-addressed (blobs/<sha256>) so
+// a resource fetched by many pages is stored once; index.jsonl maps each
+// request to its response, in the order it was seen.
+class NetArchive {
+public:
+    explicit NetArchive(const QString &dir);
+
+    bool load();
+    bool openForAppend();
+    void append(const QByteArray &key, const QByteArray &method, const QUrl &url,
+                const ArchivedResponse &response, const QByteArray &body);
+    // Repeats of a request are served in recorded order, then the last one sticks.
+    bool find(const QByteArray &key, ArchivedResponse *response);
+    QByteArray body(const QByteArray &hash) const;
+    int size() const { return entries.size(); }
+    QString path() const { return dir; }
+
+    static QByteArray requestKey(const QByteArray &method, const QUrl &url, const QByteArray &body);
+
+private:
+    QString dir;
+    QFile index;
+    QHash<QByteArray, QList<ArchivedResponse>> entries;
+    QHash<QByteArray, int> served;
+};
+
+// In-process HTTP(S) proxy that Chromium is pointed at with --proxy-server.
+// In Record mode every request is fetched upstream and archived; in Replay
+// mode responses only ever come from the archive, optionally slowed down by a
+// fixed per-response latency and a bandwidth cap, so page loads can be timed
+// reproducibly without the network. HTTPS is terminated locally with a
+// self-signed certificate generated on first use into user_data/replay/.
+class ReplayServer : public QTcpServer {
+    Q_OBJECT
+public:
+    enum Mode { Record, Replay };
+
+    ReplayServer(Mode mode, const QString &archiveDir, QObject *parent = nullptr);
+
+    bool start();
+    QString lastError() const { return error; }
+    void setLatency(int ms) { latencyMs = ms; }
+    void setBandwidth(int kbitPerSecond) { bytesPerSecond = qint64(kbitPerSecond) * 1000 / 8; }
+    QByteArray chromiumFlags() const;
+
+protected:
+    void incomingConnection(qintptr handle) override;
+
+private:
+    bool loadIdentity(QSslCertificate *cert, QSslKey *key);
+
+    struct Request {
+        QByteArray method;
+        QUrl url;
+        QList<QPair<QByteArray, QByteArray>> headers;
+        QByteArray body;
+    };
+    struct Connection {
+        QByteArray buffer;
+        QByteArray tunnel;
+        bool busy = false;
+    };
+
+    Mode mode;
+    NetArchive archive;
+    QNetworkAccessManager network;
+    QSslConfiguration tls;
+    QHash<QSslSocket*, Connection> connections;
+    int latencyMs = 0;
+    qint64 bytesPerSecond = 0;
+    QString error;
+
+    void readRequests(QSslSocket *socket);
+    void handle(QSslSocket *socket, const Request &request);
+    void fetch(QSslSocket *socket, const Request &request, const QByteArray &key);
+    void respond(QSslSocket *socket, const ArchivedResponse &response, const QByteArray &body);
+    void send(QSslSocket *socket, const QByteArray &data, qint64 offset);
+    void finishResponse(QSslSocket *socket);
+};
+
+#endif
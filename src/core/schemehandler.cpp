@@ -0,0 +1,68 @@
+#include "schemehandler.h"
+#include <QApplication>
+#include <QBuffer>
+#include <QFile>
+#include <QWebEngineUrlRequestJob>
+#include <QWebEngineUrlScheme>
+
+void CaptureSchemeHandler::registerScheme() {
+    QWebEngineUrlScheme scheme("capture");
+    scheme.setSyntax(QWebEngineUrlScheme::Syntax::Host);
+    // Local: web content cannot link into internal pages, while they may still
+    // pull in qrc-backed scripts.
+    scheme.setFlags(QWebEngineUrlScheme::SecureScheme | QWebEngineUrlScheme::LocalScheme
+                    | QWebEngineUrlScheme::LocalAccessAllowed);
+    QWebEngineUrlScheme::registerScheme(scheme);
+}
+
+CaptureSchemeHandler *CaptureSchemeHandler::instance() {
+    static CaptureSchemeHandler *handler = new CaptureSchemeHandler(qApp);
+    return handler;
+}
+
+CaptureSchemeHandler::CaptureSchemeHandler(QObject *parent) : QWebEngineUrlSchemeHandler(parent) {}
+
+QByteArray CaptureSchemeHandler::resource(const QString &path) {
+    auto it = cache.constFind(path);
+    if (it != cache.constEnd()) return *it;
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return QByteArray();
+    QByteArray data = f.readAll();
+    cache.insert(path, data);
+    return data;
+}
+
+void CaptureSchemeHandler::requestStarted(QWebEngineUrlRequestJob *job) {
+    if (job->requestMethod() != "GET") {
+        job->fail(QWebEngineUrlRequestJob::RequestDenied);
+        return;
+    }
+
+    // capture://<page> maps to :/pages/<page>.html, capture://assets/<file> to a
+    // shared asset; qwebchannel.js comes from Qt's own resources.
+    const QUrl url = job->requestUrl();
+    const QString host = url.host();
+    QString path;
+    QByteArray mime = "text/html";
+    QByteArray cacheControl = "no-cache";
+    if (host == "assets") {
+        const QString file = url.path().mid(1);
+        path = file == "qwebchannel.js" ? ":/qtwebchannel/qwebchannel.js" : ":/pages/" + file;
+        if (file.endsWith(".css")) mime = "text/css";
+        else if (file.endsWith(".js")) mime = "application/javascript";
+        cacheControl = "max-age=31536000, immutable";
+    } else if (!host.isEmpty() && url.path().length() <= 1) {
+        path = ":/pages/" + host + ".html";
+    }
+
+    const QByteArray data = path.isEmpty() ? QByteArray() : resource(path);
+    if (data.isEmpty()) {
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+
+    job->setAdditionalResponseHeaders({{"Cache-Control", cacheControl}});
+    auto *buffer = new QBuffer(job);
+    buffer->setData(data);
+    job->reply(mime + "; charset=utf-8", buffer);
+}
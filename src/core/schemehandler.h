@@ -0,0 +1,26 @@
+#ifndef SCHEMEHANDLER_H
+#define SCHEMEHANDLER_H
+
+#include <QHash>
+#include <QWebEngineUrlSchemeHandler>
+
+// Serves the internal capture:// pages (capture://settings, capture://history,
+// ...) and their shared assets out of the compiled-in :/pages resources.
+// Resource bytes are decoded once and then handed out from memory.
+class CaptureSchemeHandler : public QWebEngineUrlSchemeHandler {
+    Q_OBJECT
+public:
+    // Must run before QApplication is constructed.
+    static void registerScheme();
+    static CaptureSchemeHandler *instance();
+
+    void requestStarted(QWebEngineUrlRequestJob *job) override;
+
+private:
+    explicit CaptureSchemeHandler(QObject *parent);
+    QHash<QString, QByteArray> cache;
+
+    QByteArray resource(const QString &path);
+};
+
+#endif
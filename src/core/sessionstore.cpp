@@ -0,0 +1,173 @@
+#include "sessionstore.h"
+#include "tabmanager.h"
+#include <QApplication>
+#include <QFile>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <QWebEngineView>
+#include <QWebEnginePage>
+#include <QWebEngineHistory>
+
+static const quint32 SessionMagic = 0x43534553; // "CSES"
+static const quint16 SessionVersion = 1;
+
+QDataStream &operator<<(QDataStream &out, const SessionTab &tab) {
+    return out << tab.url << tab.title << tab.scrollPosition << tab.history;
+}
+
+QDataStream &operator>>(QDataStream &in, SessionTab &tab) {
+    return in >> tab.url >> tab.title >> tab.scrollPosition >> tab.history;
+}
+
+static void writeSnapshot(const QString &path, const QByteArray &data) {
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) return;
+    f.write(data);
+    f.commit();
+}
+
+SessionStore::SessionStore(const QString &path, TabManager *tabs, QObject *parent)
+    : QObject(parent), path(path), tabs(tabs), writing(std::make_shared<std::atomic_bool>(false)) {
+    connect(tabs, &TabManager::viewCreated, this, &SessionStore::watch);
+    connect(tabs, &TabManager::pageAdopted, this, &SessionStore::watchPage);
+    connect(tabs, &TabManager::tabReleased, this, &SessionStore::unwatch);
+    connect(tabs, &TabManager::tabAccepted, this, &SessionStore::adopt);
+    connect(tabs, &TabManager::tabsChanged, this, [this]() { structureDirty = true; });
+    connect(qApp, &QApplication::aboutToQuit, this, &SessionStore::saveNow);
+
+    timer.setInterval(5000);
+    connect(&timer, &QTimer::timeout, this, &SessionStore::save);
+    timer.start();
+}
+
+void SessionStore::watch(QWebEngineView *view) {
+    connect(view, &QWebEngineView::urlChanged, this, [this, view]() { markDirty(view); });
+    connect(view, &QWebEngineView::titleChanged, this, [this, view]() { markDirty(view); });
+    connect(view, &QObject::destroyed, this, [this, view]() {
+        blobs.remove(view);
+        dirty.remove(view);
+    });
+    watchPage(view);
+}
+
+void SessionStore::watchPage(QWebEngineView *view) {
+    connect(view->page(), &QWebEnginePage::scrollPositionChanged, this, [this, view]() { markDirty(view); });
+    markDirty(view);
+}
+
+// Tabs moved to another window leave this session and those moved in join it,
+// placeholders included.
+void SessionStore::unwatch(QWidget *tab) {
+    disconnect(tab, nullptr, this, nullptr);
+    if (auto *view = qobject_cast<QWebEngineView*>(tab)) disconnect(view->page(), nullptr, this, nullptr);
+    blobs.remove(tab);
+    dirty.remove(tab);
+    structureDirty = true;
+}
+
+void SessionStore::adopt(QWidget *tab) {
+    if (auto *view = qobject_cast<QWebEngineView*>(tab)) watch(view);
+    else if (auto *placeholder = qobject_cast<TabPlaceholder*>(tab)) keepPlaceholder(placeholder);
+}
+
+void SessionStore::keepPlaceholder(TabPlaceholder *placeholder) {
+    QByteArray blob;
+    QDataStream out(&blob, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << placeholder->tab;
+    blobs.insert(placeholder, blob);
+    connect(placeholder, &QObject::destroyed, this, [this, placeholder]() { blobs.remove(placeholder); });
+}
+
+void SessionStore::markDirty(QWidget *tab) {
+    dirty.insert(tab);
+}
+
+bool SessionStore::restore() {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&f);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic;
+    quint16 version;
+    qint32 current, count;
+    in >> magic >> version >> current >> count;
+    if (magic != SessionMagic || version != SessionVersion || count <= 0) return false;
+
+    QList<SessionTab> restored;
+    for (int i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QByteArray blob;
+        in >> blob;
+        QDataStream tabIn(blob);
+        tabIn.setVersion(QDataStream::Qt_6_0);
+        SessionTab tab;
+        tabIn >> tab;
+        if (tabIn.status() == QDataStream::Ok) restored.append(tab);
+    }
+    if (restored.isEmpty()) return false;
+
+    for (const SessionTab &tab : restored) {
+        keepPlaceholder(tabs->addPlaceholderTab(tab));
+    }
+    tabs->activateTab(qBound(0, int(current), tabs->count() - 1));
+    return true;
+}
+
+QByteArray SessionStore::snapshot() {
+    for (QWidget *tab : std::as_const(dirty)) {
+        auto *view = qobject_cast<QWebEngineView*>(tab);
+        if (!view) continue;
+        SessionTab state;
+        state.url = view->url();
+        state.title = view->title();
+        state.scrollPosition = view->page()->scrollPosition();
+        QDataStream historyOut(&state.history, QIODevice::WriteOnly);
+        historyOut << *view->history();
+
+        QByteArray blob;
+        QDataStream out(&blob, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_6_0);
+        out << state;
+        blobs.insert(view, blob);
+    }
+    dirty.clear();
+    structureDirty = false;
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    // Tabs without a blob are skipped, so the current tab is stored as its
+    // position among the saved ones, or the saved tab just before it.
+    QList<QByteArray> ordered;
+    qint32 current = 0;
+    for (int i = 0; i < tabs->count(); ++i) {
+        auto it = blobs.constFind(tabs->widget(i));
+        if (it != blobs.constEnd()) ordered.append(it.value());
+        if (i == tabs->currentIndex()) current = qMax(0, int(ordered.size()) - 1);
+    }
+    out << SessionMagic << SessionVersion << current << qint32(ordered.size());
+    for (const QByteArray &blob : ordered) out << blob;
+    return data;
+}
+
+void SessionStore::save() {
+    if (dirty.isEmpty() && !structureDirty) return;
+    // Keep the dirty set for the next tick rather than racing the previous write.
+    if (writing->load()) return;
+
+    writing->store(true);
+    QByteArray data = snapshot();
+    QString target = path;
+    std::shared_ptr<std::atomic_bool> flag = writing;
+    QThreadPool::globalInstance()->start([target, data, flag]() {
+        writeSnapshot(target, data);
+        flag->store(false);
+    });
+}
+
+void SessionStore::saveNow() {
+    timer.stop();
+    while (writing->load()) QThreadPool::globalInstance()->waitForDone(50);
+    writeSnapshot(path, snapshot());
+}
@@ -0,0 +1,70 @@
+#ifndef SESSIONSTORE_H
+#define SESSIONSTORE_H
+
+#include <QObject>
+#include <QWidget>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include <QUrl>
+#include <QPointF>
+#include <QByteArray>
+#include <QDataStream>
+#include <memory>
+#include <atomic>
+
+class TabManager;
+class QWebEngineView;
+
+struct SessionTab {
+    QUrl url;
+    QString title;
+    QPointF scrollPosition;
+    QByteArray history;
+};
+
+QDataStream &operator<<(QDataStream &out, const SessionTab &tab);
+QDataStream &operator>>(QDataStream &in, SessionTab &tab);
+
+// Stand-in for a restored tab whose QWebEngineView has not been built yet.
+class TabPlaceholder : public QWidget {
+    Q_OBJECT
+public:
+    explicit TabPlaceholder(const SessionTab &tab, QWidget *parent = nullptr)
+        : QWidget(parent), tab(tab) {}
+    SessionTab tab;
+};
+
+// Periodically snapshots every tab of a TabManager to a binary file. Only tabs
+// that changed since the last snapshot are re-serialized, and the file itself
+// is written on a pool thread through QSaveFile (write-then-rename).
+class SessionStore : public QObject {
+    Q_OBJECT
+public:
+    SessionStore(const QString &path, TabManager *tabs, QObject *parent = nullptr);
+
+    bool restore();
+    void saveNow();
+
+private slots:
+    void watch(QWebEngineView *view);
+    void watchPage(QWebEngineView *view);
+    void unwatch(QWidget *tab);
+    void adopt(QWidget *tab);
+    void save();
+
+private:
+    QString path;
+    TabManager *tabs;
+    QTimer timer;
+    QHash<QWidget*, QByteArray> blobs;
+    QSet<QWidget*> dirty;
+    bool structureDirty = false;
+    std::shared_ptr<std::atomic_bool> writing;
+
+    void markDirty(QWidget *tab);
+    void keepPlaceholder(TabPlaceholder *placeholder);
+    QByteArray snapshot();
+};
+
+#endif
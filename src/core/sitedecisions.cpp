@@ -0,0 +1,109 @@
+#include "sitedecisions.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QSslCertificate>
+
+SiteDecisions::SiteDecisions(const QString &path, QObject *parent) : QObject(parent), path(path) {
+    saveTimer.setSingleShot(true);
+    saveTimer.setInterval(1000);
+    connect(&saveTimer, &QTimer::timeout, this, &SiteDecisions::save);
+    connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() { if (saveTimer.isActive()) save(); });
+    load();
+}
+
+QString SiteDecisions::permissionName(QWebEnginePermission::PermissionType type) {
+    switch (type) {
+    case QWebEnginePermission::PermissionType::MediaAudioCapture: return "Microphone";
+    case QWebEnginePermission::PermissionType::MediaVideoCapture: return "Camera";
+    case QWebEnginePermission::PermissionType::MediaAudioVideoCapture: return "Camera & Microphone";
+    case QWebEnginePermission::PermissionType::Geolocation: return "Location";
+    case QWebEnginePermission::PermissionType::Notifications: return "Notifications";
+    case QWebEnginePermission::PermissionType::DesktopVideoCapture:
+    case QWebEnginePermission::PermissionType::DesktopAudioVideoCapture: return "Screen Sharing";
+    default: return "Unknown Device";
+    }
+}
+
+QString SiteDecisions::permissionKey(const QWebEnginePermission &permission) {
+    return permission.origin().toString() + "|permission:" + QString::number(int(permission.permissionType()));
+}
+
+QString SiteDecisions::certificateKey(const QWebEngineCertificateError &error) {
+    const QList<QSslCertificate> chain = error.certificateChain();
+    const QByteArray fingerprint = chain.isEmpty() ? QByteArray() : chain.first().digest(QCryptographicHash::Sha256).toHex();
+    return error.url().adjusted(QUrl::RemovePath | QUrl::RemoveQuery | QUrl::RemoveFragment | QUrl::RemoveUserInfo).toString()
+           + "|certificate:" + QString::number(int(error.type())) + ":" + fingerprint;
+}
+
+SiteDecisions::Decision SiteDecisions::lookup(const QString &key) const {
+    auto it = entries.constFind(key);
+    if (it == entries.constEnd()) return Ask;
+    return it->allow ? Allow : Deny;
+}
+
+SiteDecisions::Decision SiteDecisions::permission(const QWebEnginePermission &permission) const {
+    return lookup(permissionKey(permission));
+}
+
+SiteDecisions::Decision SiteDecisions::certificate(const QWebEngineCertificateError &error) const {
+    return lookup(certificateKey(error));
+}
+
+void SiteDecisions::setPermission(const QWebEnginePermission &permission, bool allow) {
+    remember(permissionKey(permission), {permission.origin().toString(), permissionName(permission.permissionType()), allow});
+}
+
+void SiteDecisions::setCertificate(const QWebEngineCertificateError &error, bool allow) {
+    remember(certificateKey(error), {error.url().host(), "Certificate: " + error.description(), allow});
+}
+
+void SiteDecisions::remember(const QString &key, const Entry &entry) {
+    entries.insert(key, entry);
+    saveTimer.start();
+    emit changed();
+}
+
+void SiteDecisions::forget(const QString &key) {
+    if (!entries.remove(key)) return;
+    saveTimer.start();
+    emit changed();
+}
+
+void SiteDecisions::clear() {
+    entries.clear();
+    saveTimer.start();
+    emit changed();
+}
+
+QString SiteDecisions::entriesJson() const {
+    QJsonArray array;
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+        array.append(QJsonObject{{"key", it.key()}, {"origin", it->origin}, {"label", it->label}, {"allow", it->allow}});
+    }
+    return QString::fromUtf8(QJsonDocument(array).toJson(QJsonDocument::Compact));
+}
+
+void SiteDecisions::load() {
+    if (path.isEmpty()) return;
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return;
+
+    const QJsonArray array = QJsonDocument::fromJson(f.readAll()).array();
+    for (const QJsonValue &v : array) {
+        const QJsonObject o = v.toObject();
+        entries.insert(o["key"].toString(), {o["origin"].toString(), o["label"].toString(), o["allow"].toBool()});
+    }
+}
+
+void SiteDecisions::save() {
+    if (path.isEmpty()) return;
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) return;
+    f.write(entriesJson().toUtf8());
+    f.commit();
+}
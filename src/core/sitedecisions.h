@@ -0,0 +1,56 @@
+#ifndef SITEDECISIONS_H
+#define SITEDECISIONS_H
+
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+#include <QUrl>
+#include <QWebEngineCertificateError>
+#include <QWebEnginePermission>
+
+// Per-profile answers to permission and certificate prompts, keyed by origin
+// and question so a repeat request is settled with one hash lookup and no UI.
+// Certificate answers also key on the certificate's fingerprint: a site that
+// presents a different certificate is asked about again. Persisted as JSON
+// next to the profile; off-the-record profiles keep them in memory only.
+class SiteDecisions : public QObject {
+    Q_OBJECT
+public:
+    enum Decision { Ask, Allow, Deny };
+
+    explicit SiteDecisions(const QString &path, QObject *parent = nullptr);
+
+    Decision permission(const QWebEnginePermission &permission) const;
+    void setPermission(const QWebEnginePermission &permission, bool allow);
+    Decision certificate(const QWebEngineCertificateError &error) const;
+    void setCertificate(const QWebEngineCertificateError &error, bool allow);
+
+    static QString permissionName(QWebEnginePermission::PermissionType type);
+
+    Q_INVOKABLE QString entriesJson() const;
+    Q_INVOKABLE void forget(const QString &key);
+    Q_INVOKABLE void clear();
+
+signals:
+    void changed();
+
+private:
+    struct Entry {
+        QString origin;
+        QString label;
+        bool allow = false;
+    };
+
+    QString path;
+    QHash<QString, Entry> entries;
+    QTimer saveTimer;
+
+    static QString permissionKey(const QWebEnginePermission &permission);
+    static QString certificateKey(const QWebEngineCertificateError &error);
+    Decision lookup(const QString &key) const;
+    void remember(const QString &key, const Entry &entry);
+    void load();
+    void save();
+};
+
+#endif
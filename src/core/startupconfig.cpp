@@ -0,0 +1,99 @@
+#include "startupconfig.h"
+#include <QCommandLineParser>
+#include <QSettings>
+
+static const char *const ProcessModels[] = {"site-instance", "site", "single"};
+static const char *const GpuModes[] = {"auto", "off"};
+static const char *const RasterModes[] = {"auto", "gpu", "software"};
+
+static StartupConfig activeConfig;
+
+template <size_t N>
+static int indexOf(const char *const (&names)[N], const QString &value) {
+    for (size_t i = 0; i < N; ++i) {
+        if (value == QLatin1String(names[i])) return int(i);
+    }
+    return -1;
+}
+
+void StartupConfig::addOptions(QCommandLineParser &parser) {
+    parser.addOption({"process-model", "Renderer process model: site-instance (default), site or single.", "model"});
+    parser.addOption({"renderer-process-limit", "Most renderer processes Chromium may run (0 = its own default).", "n"});
+    parser.addOption({"gpu", "GPU use: auto or off.", "mode"});
+    parser.addOption({"raster", "Rasterization: auto, gpu or software.", "mode"});
+    parser.addOption({"raster-threads", "Number of raster worker threads (0 = Chromium's default).", "n"});
+}
+
+// Unknown keys and values are reported and otherwise ignored, so a bad
+// config file never keeps the browser from starting.
+void StartupConfig::set(const QString &key, const QString &value) {
+    bool ok = true;
+    if (key == "process-model") {
+        const int i = indexOf(ProcessModels, value);
+        if ((ok = i >= 0)) processModel = ProcessModel(i);
+    } else if (key == "renderer-process-limit") {
+        const int n = value.toInt(&ok);
+        if ((ok = ok && n >= 0)) rendererProcessLimit = n;
+    } else if (key == "gpu") {
+        const int i = indexOf(GpuModes, value);
+        if ((ok = i >= 0)) gpu = Gpu(i);
+    } else if (key == "raster") {
+        const int i = indexOf(RasterModes, value);
+        if ((ok = i >= 0)) raster = Raster(i);
+    } else if (key == "raster-threads") {
+        const int n = value.toInt(&ok);
+        if ((ok = ok && n >= 0)) rasterThreads = n;
+    } else {
+        qWarning("Unknown engine setting %s", qPrintable(key));
+        return;
+    }
+    if (!ok) qWarning("Ignoring %s = %s", qPrintable(key), qPrintable(value));
+}
+
+StartupConfig StartupConfig::load(const QString &iniPath, const QCommandLineParser &parser) {
+    StartupConfig config;
+    QSettings ini(iniPath, QSettings::IniFormat);
+    ini.beginGroup("engine");
+    const QStringList keys = ini.childKeys();
+    for (const QString &key : keys) config.set(key, ini.value(key).toString().trimmed());
+    ini.endGroup();
+
+    for (const char *key : {"process-model", "renderer-process-limit", "gpu", "raster", "raster-threads"}) {
+        if (parser.isSet(key)) config.set(key, parser.value(key));
+    }
+    return config;
+}
+
+QByteArray StartupConfig::chromiumFlags() const {
+    QByteArrayList flags;
+    if (processModel == PerSite) flags << "--process-per-site";
+    else if (processModel == SingleProcess) flags << "--single-process";
+    if (rendererProcessLimit > 0 && processModel != SingleProcess)
+        flags << "--renderer-process-limit=" + QByteArray::number(rendererProcessLimit);
+    if (gpu == GpuOff) flags << "--disable-gpu" << "--disable-gpu-compositing";
+    if (raster == RasterGpu) flags << "--enable-gpu-rasterization";
+    else if (raster == RasterSoftware) flags << "--disable-gpu-rasterization";
+    if (rasterThreads > 0) flags << "--num-raster-threads=" + QByteArray::number(rasterThreads);
+    return flags.join(' ');
+}
+
+void StartupConfig::apply() const {
+    activeConfig = *this;
+    const QByteArray own = chromiumFlags();
+    if (own.isEmpty()) return;
+    QByteArray flags = qgetenv("QTWEBENGINE_CHROMIUM_FLAGS");
+    qputenv("QTWEBENGINE_CHROMIUM_FLAGS", (flags + " " + own).trimmed());
+}
+
+const StartupConfig &StartupConfig::active() {
+    return activeConfig;
+}
+
+QJsonObject StartupConfig::toJson() const {
+    return QJsonObject{{"processModel", ProcessModels[processModel]},
+                       {"rendererProcessLimit", rendererProcessLimit},
+                       {"gpu", GpuModes[gpu]},
+                       {"raster", RasterModes[raster]},
+                       {"rasterThreads", rasterThreads},
+                       {"chromiumFlags", QString::fromLatin1(qgetenv("QTWEBENGINE_CHROMIUM_FLAGS"))}};
+}
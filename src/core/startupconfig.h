@@ -0,0 +1,41 @@
+#ifndef STARTUPCONFIG_H
+#define STARTUPCONFIG_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+class QCommandLineParser;
+
+// Engine settings Chromium only reads once, at startup: the renderer process
+// model, a cap on renderer processes, and GPU/raster use for machines without
+// a usable GPU. Read from user_data/config.ini ([engine] section), overridden
+// by the matching command-line flags, and handed to Chromium through
+// QTWEBENGINE_CHROMIUM_FLAGS before the first profile is created.
+class StartupConfig {
+public:
+    enum ProcessModel { PerSiteInstance, PerSite, SingleProcess };
+    enum Gpu { GpuAuto, GpuOff };
+    enum Raster { RasterAuto, RasterGpu, RasterSoftware };
+
+    ProcessModel processModel = PerSiteInstance;
+    int rendererProcessLimit = 0;
+    Gpu gpu = GpuAuto;
+    Raster raster = RasterAuto;
+    int rasterThreads = 0;
+
+    static void addOptions(QCommandLineParser &parser);
+    static StartupConfig load(const QString &iniPath, const QCommandLineParser &parser);
+
+    QByteArray chromiumFlags() const;
+    void apply() const;
+    QJsonObject toJson() const;
+
+    // What apply() last put in place, for reporting alongside measurements.
+    static const StartupConfig &active();
+
+private:
+    void set(const QString &key, const QString &value);
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include "tabchrome.h"
+#include "tabmanager.h"
+#include "browser.h"
+#include <QElapsedTimer>
+#include <QScreen>
+
+TabChrome::TabChrome(TabManager *tabs) : QObject(tabs), tabs(tabs) {
+    frame.setSingleShot(true);
+    frame.setTimerType(Qt::PreciseTimer);
+    connect(&frame, &QTimer::timeout, this, &TabChrome::flush);
+}
+
+QString TabChrome::label(const QString &title) {
+    return title.isEmpty() ? QStringLiteral("New Tab") : title.left(18);
+}
+
+TabChrome::State &TabChrome::state(QWebEngineView *view) {
+    auto it = states.find(view);
+    if (it != states.end()) return it.value();
+    connect(view, &QObject::destroyed, this, [this, view]() { states.remove(view); });
+    return states.insert(view, State()).value();
+}
+
+void TabChrome::forget(QWebEngineView *view) {
+    disconnect(view, &QObject::destroyed, this, nullptr);
+    states.remove(view);
+}
+
+void TabChrome::mark(State &s, int field) {
+    counters.events++;
+    s.dirty |= field;
+    if (frame.isActive()) return;
+    // Widgets have no vsync callback; a one-shot at the screen's frame
+    // interval is the closest thing and never fires more often than that.
+    const QScreen *screen = tabs->screen();
+    const qreal hz = screen && screen->refreshRate() > 0 ? screen->refreshRate() : 60;
+    frame.start(qMax(4, qRound(1000 / hz)));
+}
+
+void TabChrome::setUrl(QWebEngineView *view, const QUrl &url) {
+    State &s = state(view);
+    s.url = url;
+    mark(s, Url);
+}
+
+void TabChrome::setTitle(QWebEngineView *view, const QString &title) {
+    State &s = state(view);
+    s.title = title;
+    mark(s, Title);
+}
+
+void TabChrome::setIcon(QWebEngineView *view, const QIcon &icon) {
+    State &s = state(view);
+    s.icon = icon;
+    mark(s, Icon);
+}
+
+void TabChrome::setProgress(QWebEngineView *view, int progress) {
+    State &s = state(view);
+    if (s.progress == progress) return;
+    s.progress = progress;
+    mark(s, Progress);
+}
+
+void TabChrome::showCurrent() {
+    auto *view = qobject_cast<QWebEngineView*>(tabs->currentWidget());
+    if (!view) return;
+    State &s = state(view);
+    s.url = view->url();
+    s.dirty |= Url | Progress;
+    flush();
+}
+
+void TabChrome::flush() {
+    QElapsedTimer t;
+    t.start();
+    frame.stop();
+
+    QWidget *current = tabs->currentWidget();
+    auto *window = qobject_cast<Browser*>(tabs->window());
+    for (auto it = states.begin(); it != states.end(); ++it) {
+        State &s = it.value();
+        if (!s.dirty) continue;
+        QWebEngineView *view = it.key();
+        const int i = tabs->indexOf(view);
+        if (i != -1) {
+            if (s.dirty & Title) {
+                const QString text = label(s.title);
+                if (tabs->tabText(i) != text) tabs->setTabText(i, text);
+            }
+            if (s.dirty & Icon && tabs->tabIcon(i).cacheKey() != s.icon.cacheKey()) tabs->setTabIcon(i, s.icon);
+        }
+        if (view == current && window) {
+            if (s.dirty & Url) window->showUrl(s.url);
+            if (s.dirty & Progress) window->updateUI(s.progress);
+        }
+        s.dirty = 0;
+    }
+
+    counters.flushes++;
+    counters.flushNs += t.nsecsElapsed();
+}
@@ -0,0 +1,63 @@
+#ifndef TABCHROME_H
+#define TABCHROME_H
+
+#include <QObject>
+#include <QHash>
+#include <QIcon>
+#include <QTimer>
+#include <QUrl>
+#include <QWebEngineView>
+
+class TabManager;
+
+// Per-tab URL, title, icon and progress as last reported by the views. View
+// signals only write here; the window chrome (tab labels, address bar, SSL
+// badge, progress bar) is brought up to date from the dirty entries at most
+// once per display frame, so a burst of loads costs one repaint, not hundreds.
+class TabChrome : public QObject {
+    Q_OBJECT
+public:
+    explicit TabChrome(TabManager *tabs);
+
+    struct Stats {
+        qint64 events = 0;
+        qint64 flushes = 0;
+        qint64 flushNs = 0;
+    };
+
+    void setUrl(QWebEngineView *view, const QUrl &url);
+    void setTitle(QWebEngineView *view, const QString &title);
+    void setIcon(QWebEngineView *view, const QIcon &icon);
+    void setProgress(QWebEngineView *view, int progress);
+
+    // Re-reads the current tab from its view and applies it right away, for
+    // tab switches and other user-driven changes that should not wait a frame.
+    void showCurrent();
+    void forget(QWebEngineView *view);
+
+    Stats stats() const { return counters; }
+    void resetStats() { counters = Stats(); }
+
+    static QString label(const QString &title);
+
+private:
+    enum Field { Url = 1, Title = 2, Icon = 4, Progress = 8 };
+    struct State {
+        QUrl url;
+        QString title;
+        QIcon icon;
+        int progress = 100;
+        int dirty = 0;
+    };
+
+    TabManager *tabs;
+    QHash<QWebEngineView*, State> states;
+    QTimer frame;
+    Stats counters;
+
+    State &state(QWebEngineView *view);
+    void mark(State &s, int field);
+    void flush();
+};
+
+#endif
@@ -0,0 +1,94 @@
+#include "tablifecycle.h"
+#include "tabmanager.h"
+#include "processmemory.h"
+#include <QWebEnginePage>
+#include <algorithm>
+
+TabLifecycleManager::TabLifecycleManager(TabManager *tabs) : QObject(tabs), tabs(tabs) {
+    clock.start();
+    sweepTimer.setInterval(15 * 1000);
+    connect(&sweepTimer, &QTimer::timeout, this, &TabLifecycleManager::sweep);
+    sweepTimer.start();
+}
+
+void TabLifecycleManager::track(QWebEngineView *view) {
+    lastActive.insert(view, clock.elapsed());
+    connect(view, &QObject::destroyed, this, [this, view]() { lastActive.remove(view); });
+}
+
+void TabLifecycleManager::untrack(QWebEngineView *view) {
+    lastActive.remove(view);
+    disconnect(view, &QObject::destroyed, this, nullptr);
+}
+
+void TabLifecycleManager::activate(QWebEngineView *view) {
+    if (!lastActive.contains(view)) return;
+    lastActive[view] = clock.elapsed();
+
+    // A discarded page reloads its last committed URL when it becomes active again.
+    if (view->page()->lifecycleState() != QWebEnginePage::LifecycleState::Active)
+        view->page()->setLifecycleState(QWebEnginePage::LifecycleState::Active);
+
+    if (liveTabCount() > maxLiveTabs) sweep();
+}
+
+int TabLifecycleManager::liveTabCount() const {
+    int live = 0;
+    for (auto it = lastActive.cbegin(); it != lastActive.cend(); ++it) {
+        if (it.key()->page()->lifecycleState() != QWebEnginePage::LifecycleState::Discarded) live++;
+    }
+    return live;
+}
+
+bool TabLifecycleManager::canEnter(QWebEngineView *view, QWebEnginePage::LifecycleState state) const {
+    if (view == tabs->currentWidget()) return false;
+    // A view outside its tab is on screen elsewhere, e.g. picture-in-picture.
+    if (tabs->indexOf(view) == -1) return false;
+    // recommendedState is the lowest state Chromium considers safe: it stays
+    // Active for audible, capturing or inspected pages.
+    return view->page()->recommendedState() >= state;
+}
+
+void TabLifecycleManager::discard(QWebEngineView *view) {
+    view->page()->setLifecycleState(QWebEnginePage::LifecycleState::Discarded);
+}
+
+void TabLifecycleManager::sweep() {
+    const qint64 now = clock.elapsed();
+    QList<QWebEngineView*> live;
+
+    for (auto it = lastActive.cbegin(); it != lastActive.cend(); ++it) {
+        QWebEngineView *view = it.key();
+        QWebEnginePage::LifecycleState state = view->page()->lifecycleState();
+        if (state == QWebEnginePage::LifecycleState::Discarded) continue;
+
+        const qint64 idle = now - it.value();
+        if (idle > discardAfter && canEnter(view, QWebEnginePage::LifecycleState::Discarded)) {
+            discard(view);
+            continue;
+        }
+        if (memoryBudget > 0 && canEnter(view, QWebEnginePage::LifecycleState::Discarded)
+                && processResidentBytes(view->page()->renderProcessPid()) > memoryBudget) {
+            discard(view);
+            continue;
+        }
+        if (state == QWebEnginePage::LifecycleState::Active && idle > freezeAfter
+                && canEnter(view, QWebEnginePage::LifecycleState::Frozen)) {
+            view->page()->setLifecycleState(QWebEnginePage::LifecycleState::Frozen);
+        }
+        live.append(view);
+    }
+
+    if (live.size() <= maxLiveTabs) return;
+
+    std::sort(live.begin(), live.end(), [this](QWebEngineView *a, QWebEngineView *b) {
+        return lastActive.value(a) < lastActive.value(b);
+    });
+    int excess = live.size() - maxLiveTabs;
+    for (QWebEngineView *view : live) {
+        if (excess == 0) break;
+        if (!canEnter(view, QWebEnginePage::LifecycleState::Discarded)) continue;
+        discard(view);
+        excess--;
+    }
+}
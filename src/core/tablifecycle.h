@@ -0,0 +1,48 @@
+#ifndef TABLIFECYCLE_H
+#define TABLIFECYCLE_H
+
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QWebEngineView>
+
+class TabManager;
+
+// Moves background tabs through Active -> Frozen -> Discarded once they have
+// been idle long enough, and discards least-recently-used tabs when too many
+// renderers are alive or a tab's renderer grows past its memory budget.
+class TabLifecycleManager : public QObject {
+    Q_OBJECT
+public:
+    explicit TabLifecycleManager(TabManager *tabs);
+
+    void track(QWebEngineView *view);
+    void untrack(QWebEngineView *view);
+    void activate(QWebEngineView *view);
+
+    void setFreezeAfter(int ms) { freezeAfter = ms; }
+    void setDiscardAfter(int ms) { discardAfter = ms; }
+    void setMaxLiveTabs(int count) { maxLiveTabs = count; }
+    void setMemoryBudget(qint64 bytesPerTab) { memoryBudget = bytesPerTab; }
+
+    int liveTabCount() const;
+
+public slots:
+    void sweep();
+
+private:
+    TabManager *tabs;
+    QHash<QWebEngineView*, qint64> lastActive;
+    QElapsedTimer clock;
+    QTimer sweepTimer;
+    int freezeAfter = 5 * 60 * 1000;
+    int discardAfter = 30 * 60 * 1000;
+    int maxLiveTabs = 16;
+    qint64 memoryBudget = 512ll * 1024 * 1024;
+
+    bool canEnter(QWebEngineView *view, QWebEnginePage::LifecycleState state) const;
+    void discard(QWebEngineView *view);
+};
+
+#endif
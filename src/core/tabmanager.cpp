@@ -1,16 +1,34 @@
 #include "tabmanager.h"
 #include "browser.h"
+#include "tablifecycle.h"
+#include "sessionstore.h"
+#include "perftrace.h"
+#include "tabchrome.h"
 #include <QWebEnginePage>
 #include <QWebEngineProfile>
 #include <QWebEnginePermission>
 #include <QToolButton>
+#include <QLabel>
 #include <QPropertyAnimation>
 #include <QWebChannel>
-#include <QMessageBox>
+#include <QWebEngineHistory>
+#include <QWebEngineNavigationRequest>
+#include <QWebEngineNewWindowRequest>
+#include <QDataStream>
+#include <QApplication>
+#include <QDrag>
+#include <QCursor>
+#include <QMimeData>
+#include <QMouseEvent>
+#include <QDragEnterEvent>
+#include <QDropEvent>
 
-TabManager::TabManager(QWidget *parent) : QTabWidget(parent) {
+TabManager::TabManager(QWebEngineProfile *profile, QWidget *parent) : QTabWidget(parent), webProfile(profile) {
     setTabsClosable(true);
     setMovable(true);
+    lifecycleManager = new TabLifecycleManager(this);
+    chrome = new TabChrome(this);
+    channel = new QWebChannel(this);
     
     QToolButton *btn = new QToolButton(this);
     btn->setText("+");
@@ -18,15 +36,25 @@ TabManager::TabManager(QWidget *parent) : QTabWidget(parent) {
     setCornerWidget(btn, Qt::TopRightCorner);
 
     connect(btn, &QToolButton::clicked, this, &TabManager::handleNewTabButtonClick);
-    connect(this, &QTabWidget::tabCloseRequested, [this](int idx) { if(count() > 1) removeTab(idx); });
+    connect(this, &QTabWidget::tabCloseRequested, this, &TabManager::closeTab);
+
+    spareTimer.setSingleShot(true);
+    spareTimer.setInterval(1000);
+    connect(&spareTimer, &QTimer::timeout, this, &TabManager::refillSpares);
+    spareTimer.start();
+
+    setAcceptDrops(true);
+    tabBar()->installEventFilter(this);
+
+    connect(tabBar(), &QTabBar::tabMoved, this, &TabManager::tabsChanged);
+    connect(this, &QTabWidget::currentChanged, this, &TabManager::tabsChanged);
 
     connect(this, &QTabWidget::currentChanged, [this](int index) {
         if (index != -1) {
+            if (qobject_cast<TabPlaceholder*>(widget(index))) materialize(index);
             if (auto *view = qobject_cast<QWebEngineView*>(widget(index))) {
-                if (auto *mainWindow = qobject_cast<Browser*>(window())) {
-                    mainWindow->addressBar->setText(view->url().toString());
-                    mainWindow->updateSslIcon(view->url());
-                }
+                lifecycleManager->activate(view);
+                chrome->showCurrent();
             }
         }
     });
@@ -36,141 +64,263 @@ void TabManager::handleNewTabButtonClick() {
     createNewTab(QUrl("https://www.google.com"));
 }
 
-QWebEngineView* TabManager::createNewTab(const QUrl &url) {
-    QWebEngineView *view = new QWebEngineView;
-    view->page()->setBackgroundColor(QColor("#0a0a0a"));
-    
-    connect(view->page(), &QWebEnginePage::permissionRequested, [this](QWebEnginePermission permission) {
-        QString type = "Unknown Device";
-        auto pType = permission.permissionType();
-
-        if (pType == QWebEnginePermission::PermissionType::MediaAudioCapture) 
-            type = "Microphone";
-        else if (pType == QWebEnginePermission::PermissionType::MediaVideoCapture) 
-            type = "Camera";
-        else if (pType == QWebEnginePermission::PermissionType::MediaAudioVideoCapture)
-            type = "Camera & Microphone";
-        else if (pType == QWebEnginePermission::PermissionType::Geolocation)
-            type = "Location";
-        else if (pType == QWebEnginePermission::PermissionType::Notifications)
-            type = "Notifications";
-        else if (pType == QWebEnginePermission::PermissionType::DesktopVideoCapture || 
-                pType == QWebEnginePermission::PermissionType::DesktopAudioVideoCapture)
-            type = "Screen Sharing";
-
-        QMessageBox::StandardButton res = QMessageBox::question(this, "Permission Request",
-            QString("The website wants to access your %1. Allow?").arg(type));
-        
-        if (res == QMessageBox::Yes) {
-            permission.grant();
-        } else {
-            permission.deny();
-        }
-    });
+QWebEngineView* TabManager::createView() {
+    QWebEngineView *view = spares.isEmpty() ? buildView() : spares.takeLast();
+    lifecycleManager->track(view);
+    PerfTracer::instance()->track(view);
+    emit viewCreated(view);
+    spareTimer.start();
+    return view;
+}
+
+// Builds a view with its page and every per-tab connection in place, but not
+// yet attached to a tab.
+QWebEngineView* TabManager::buildView() {
+    QWebEngineView *view = new QWebEngineView(this);
+    view->hide();
+    view->setPage(new QWebEnginePage(webProfile, view));
+    wirePage(view->page());
+    wireView(view);
+    return view;
+}
+
+// Per-tab connections that reach into this window's chrome. They all use this
+// TabManager as context so that moving the tab elsewhere can drop them.
+void TabManager::wireView(QWebEngineView *view) {
+    connect(view, &QWebEngineView::urlChanged, this, [this, view](const QUrl &u) { chrome->setUrl(view, u); });
+    connect(view, &QWebEngineView::loadProgress, this, [this, view](int progress) { chrome->setProgress(view, progress); });
 
-    connect(view, &QWebEngineView::urlChanged, [this, view](const QUrl &u) {
-        if (this->currentWidget() == view) {
+    connect(view, &QWebEngineView::loadFinished, this, [this, view](bool ok) {
+        if (ok) {
             if (auto *mainWindow = qobject_cast<Browser*>(window())) {
-                mainWindow->addressBar->setText(u.toString());
-
-                if (u.scheme() == "https") {
-                    mainWindow->sslLabel->setPixmap(QIcon::fromTheme("security-high").pixmap(16, 16));
-                    mainWindow->sslLabel->setStyleSheet("color: green;");
-                } else {
-                    mainWindow->sslLabel->setPixmap(QIcon::fromTheme("security-low").pixmap(16, 16));
-                    mainWindow->sslLabel->setStyleSheet("color: red;");
-                }
+                mainWindow->addHistoryEntry(view->url(), view->title());
             }
         }
     });
-    connect(view, &QWebEngineView::loadProgress, [this, view](int progress) {
-        if (this->currentWidget() == view) {
-            if (auto *mainWindow = qobject_cast<Browser*>(window())) {
-                mainWindow->updateUI(progress);
-            }
-        }
+
+    connect(view, &QWebEngineView::titleChanged, this, [this, view](const QString &t) { chrome->setTitle(view, t); });
+    connect(view, &QWebEngineView::iconChanged, this, [this, view](const QIcon &icon) { chrome->setIcon(view, icon); });
+}
+
+// Keeps a couple of ready-made views around so new tabs skip construction.
+// One is built per tick so refilling never stalls the UI for long.
+void TabManager::refillSpares() {
+    while (spares.size() > spareTarget) delete spares.takeLast();
+    if (spares.size() == spareTarget) return;
+    spares.append(buildView());
+    if (spares.size() < spareTarget) spareTimer.start();
+}
+
+void TabManager::closeTab(int index) {
+    if (count() <= 1) return;
+    QWidget *tab = widget(index);
+    removeTab(index);
+    // The view owns its page, so deleting it tears down the renderer too.
+    if (auto *view = qobject_cast<QWebEngineView*>(tab)) {
+        view->stop();
+        view->page()->setWebChannel(nullptr);
+    }
+    tab->deleteLater();
+}
+
+// Hands a tab over to another window of the same profile. The view, its page
+// and renderer carry on untouched; only the window-side wiring is redone.
+void TabManager::moveTab(int index, TabManager *target, int targetIndex) {
+    if (target == this || target->profile() != webProfile) return;
+    const QString title = tabText(index);
+    const QIcon icon = tabIcon(index);
+    QWidget *tab = releaseTab(index);
+    if (!tab) return;
+    target->acceptTab(tab, title, icon, targetIndex);
+    // A drop lands here from inside this window's QDrag::exec(); close once
+    // the drag loop has unwound rather than destroying the window under it.
+    if (count() == 0) QTimer::singleShot(0, window(), &QWidget::close);
+}
+
+QWidget *TabManager::releaseTab(int index) {
+    QWidget *tab = widget(index);
+    auto *view = qobject_cast<QWebEngineView*>(tab);
+    // Stand-ins such as the picture-in-picture one stay with their window.
+    if (!view && !qobject_cast<TabPlaceholder*>(tab)) return nullptr;
+    if (view) {
+        disconnect(view, nullptr, this, nullptr);
+        disconnect(view->page(), nullptr, this, nullptr);
+        lifecycleManager->untrack(view);
+        chrome->forget(view);
+    }
+    emit tabReleased(tab);
+    removeTab(index);
+    return tab;
+}
+
+void TabManager::acceptTab(QWidget *tab, const QString &title, const QIcon &icon, int index) {
+    if (auto *view = qobject_cast<QWebEngineView*>(tab)) {
+        wirePage(view->page());
+        wireView(view);
+        // An internal page keeps its backend, now talking to this window.
+        if (view->page()->webChannel()) view->page()->setWebChannel(channel);
+        lifecycleManager->track(view);
+    }
+    const int i = insertTab(index < 0 ? count() : index, tab, icon, title);
+    emit tabAccepted(tab);
+    setCurrentIndex(i);
+}
+
+// Takes a live view out of its tab (e.g. for picture-in-picture) without
+// stopping it, leaving a stand-in behind that keeps the tab's place.
+QWidget *TabManager::detach(QWebEngineView *view) {
+    const int i = indexOf(view);
+    auto *placeholder = new QLabel("Playing in picture-in-picture.\nClose the floating window to bring the page back.");
+    placeholder->setAlignment(Qt::AlignCenter);
+    if (i == -1) return placeholder;
+
+    const bool blocked = blockSignals(true);
+    insertTab(i, placeholder, tabIcon(i), tabText(i));
+    removeTab(i + 1);
+    setCurrentIndex(i);
+    blockSignals(blocked);
+    return placeholder;
+}
+
+bool TabManager::reattach(QWebEngineView *view, QWidget *placeholder) {
+    const int i = indexOf(placeholder);
+    if (i == -1) return false;
+
+    const bool current = currentIndex() == i;
+    const bool blocked = blockSignals(true);
+    insertTab(i, view, tabIcon(i), tabText(i));
+    removeTab(i + 1);
+    if (current) setCurrentIndex(i);
+    blockSignals(blocked);
+    placeholder->deleteLater();
+    return true;
+}
+
+void TabManager::wirePage(QWebEnginePage *page) {
+    page->setBackgroundColor(QColor("#0a0a0a"));
+
+    connect(page, &QWebEnginePage::permissionRequested, this, [this, page](QWebEnginePermission permission) {
+        auto *mainWindow = qobject_cast<Browser*>(window());
+        QWebEngineView *view = QWebEngineView::forPage(page);
+        if (mainWindow && view) mainWindow->handlePermission(view, permission);
+        else permission.deny();
     });
 
-    connect(view->page(), &QWebEnginePage::certificateError, [this](QWebEngineCertificateError error) {
-        if (auto *mainWindow = qobject_cast<Browser*>(window())) {
-            mainWindow->handleSslErrors(error);
-        }
+    // One long-lived channel per window serves every internal page, and only
+    // internal pages: it is dropped again as soon as the tab leaves capture://.
+    connect(page, &QWebEnginePage::navigationRequested, this, [this, page](QWebEngineNavigationRequest &request) {
+        if (request.isMainFrame()) page->setWebChannel(request.url().scheme() == "capture" ? channel : nullptr);
     });
 
-    connect(view, &QWebEngineView::loadFinished, [this, view](bool ok) {
-        if (ok) {
-            if (auto *mainWindow = qobject_cast<Browser*>(window())) {
-                mainWindow->addHistoryEntry(view->url()); 
-            }
-        }
+    connect(page, &QWebEnginePage::newWindowRequested, this, [this](QWebEngineNewWindowRequest &request) {
+        QWebEngineView *view = createView();
+        request.openIn(view->page());
+        int idx = addTab(view, "Loading...");
+        if (request.destination() != QWebEngineNewWindowRequest::InNewBackgroundTab) setCurrentIndex(idx);
     });
 
-    if (url.toString() == "capture://settings") {
-        QString html = R"html(
-            <html><head>
-            <script src="qrc:///qtwebchannel/qwebchannel.js"></script>
-            <script>
-                var backend;
-                new QWebChannel(qt.webChannelTransport, function (channel) {
-                    backend = channel.objects.handler;
-                });
-            </script>
-            <style>
-                body { background: #0a0a0a; color: #eee; font-family: 'Segoe UI', sans-serif; padding: 40px; }
-                .container { max-width: 800px; margin: auto; }
-                .card { background: #161616; border: 1px solid #333; padding: 20px; border-radius: 12px; margin-bottom: 15px; display: flex; justify-content: space-between; align-items: center; transition: 0.3s; }
-                .card:hover { border-color: #0078d4; background: #1a1a1a; }
-                select, button { background: #252525; color: white; border: 1px solid #444; padding: 10px; border-radius: 8px; cursor: pointer; min-width: 140px; }
-                h1 { color: #0078d4; font-size: 28px; }
-                .danger { background: #c0392b; border: none; font-weight: bold; }
-                span { color: #888; font-size: 13px; display: block; }
-            </style>
-            </head>
-            <body>
-                <div class="container">
-                    <h1>Browser Settings</h1>
-                    <div class='card'><div><b>Appearance</b><span>UI Theme Palette</span></div>
-                        <select onchange="backend.changeTheme(this.value)">
-                            <option value="Dark">Dark Mode</option>
-                            <option value="White">Light Mode</option>
-                            <option value="Private">Private (Neon)</option>
-                        </select>
-                    </div>
-                    <div class='card'><div><b>Privacy Level</b><span>Security & Tracking</span></div>
-                        <select onchange="backend.setPrivacyLevel(this.value)">
-                            <option value="None">None</option>
-                            <option value="Easy" selected>Easy</option>
-                            <option value="Hardest">Hardest (Secure)</option>
-                        </select>
-                    </div>
-                    
-                    <div class='card'><div><b>Browsing Data</b><span>Clear all persistent files</span></div>
-                        <button class='danger' onclick="backend.clearData()">Clear Everything</button>
-                    </div>
-                </div>
-            </body></html>
-        )html";
-        
-        view->setHtml(html);
-        QWebChannel *channel = new QWebChannel(view->page());
-        view->page()->setWebChannel(channel);
-        channel->registerObject(QStringLiteral("handler"), window());
-    } else {
-        view->load(url);
+    connect(page, &QWebEnginePage::certificateError, this, [this, page](QWebEngineCertificateError error) {
+        auto *mainWindow = qobject_cast<Browser*>(window());
+        QWebEngineView *view = QWebEngineView::forPage(page);
+        if (mainWindow && view) mainWindow->handleSslErrors(view, error);
+        else error.rejectCertificate();
+    });
+}
+
+// Swaps a page that was loaded off-screen (e.g. a prerender) into view and
+// brings the chrome up to date, since its load signals fired before it had a tab.
+void TabManager::adoptPage(QWebEngineView *view, QWebEnginePage *page, bool loaded) {
+    QWebEnginePage *previous = view->page();
+    page->setAudioMuted(false);
+    wirePage(page);
+    page->setParent(view);
+    view->setPage(page);
+    if (previous && previous->parent() == view) previous->deleteLater();
+    PerfTracer::instance()->mark(view, "prerenderAdopted", {{"url", page->url().toString()}, {"loaded", loaded}});
+    emit pageAdopted(view);
+
+    chrome->setTitle(view, page->title());
+    chrome->setProgress(view, 100);
+    if (currentWidget() == view) chrome->showCurrent();
+    if (loaded) {
+        if (auto *mainWindow = qobject_cast<Browser*>(window())) mainWindow->addHistoryEntry(page->url(), page->title());
     }
+}
+
+void TabManager::navigate(QWebEngineView *view, const QUrl &url) {
+    // Internal pages come from the capture:// scheme handler; the channel only
+    // has to be attached before their scripts run.
+    if (url.scheme() == "capture") view->page()->setWebChannel(channel);
+    view->load(url);
+}
+
+QWebEngineView* TabManager::createNewTab(const QUrl &url) {
+    QWebEngineView *view = createView();
+    navigate(view, url);
 
     int idx = addTab(view, "Loading...");
     setCurrentIndex(idx);
-    
-    connect(view, &QWebEngineView::titleChanged, [this, view](const QString &t) {
-        int i = indexOf(view);
-        if (i != -1) setTabText(i, t.isEmpty() ? "New Tab" : t.left(18));
-    });
-
     animateTab(idx);
     return view;
 }
 
+TabPlaceholder* TabManager::addPlaceholderTab(const SessionTab &tab) {
+    auto *placeholder = new TabPlaceholder(tab);
+    // Keep currentChanged quiet so that adding a placeholder never builds its view.
+    const bool blocked = blockSignals(true);
+    addTab(placeholder, tab.title.isEmpty() ? "New Tab" : tab.title.left(18));
+    blockSignals(blocked);
+    return placeholder;
+}
+
+void TabManager::activateTab(int index) {
+    if (index == currentIndex()) {
+        emit currentChanged(index);
+        return;
+    }
+    setCurrentIndex(index);
+}
+
+QWebEngineView* TabManager::materialize(int index) {
+    auto *placeholder = qobject_cast<TabPlaceholder*>(widget(index));
+    if (!placeholder) return qobject_cast<QWebEngineView*>(widget(index));
+
+    const SessionTab tab = placeholder->tab;
+    QWebEngineView *view = createView();
+
+    const bool blocked = blockSignals(true);
+    insertTab(index, view, tabText(index));
+    removeTab(index + 1);
+    setCurrentIndex(index);
+    blockSignals(blocked);
+    placeholder->deleteLater();
+
+    if (tab.history.isEmpty()) {
+        navigate(view, tab.url);
+    } else {
+        QDataStream in(tab.history);
+        in >> *view->history();
+    }
+
+    if (!tab.scrollPosition.isNull()) {
+        const QPointF pos = tab.scrollPosition;
+        connect(view, &QWebEngineView::loadFinished, view, [view, pos](bool ok) {
+            if (ok) view->page()->runJavaScript(QString("window.scrollTo(%1, %2);").arg(pos.x()).arg(pos.y()));
+        }, Qt::SingleShotConnection);
+    }
+    return view;
+}
+
+void TabManager::tabInserted(int index) {
+    QTabWidget::tabInserted(index);
+    emit tabsChanged();
+}
+
+void TabManager::tabRemoved(int index) {
+    QTabWidget::tabRemoved(index);
+    emit tabsChanged();
+}
+
 void TabManager::animateTab(int index) {
     QWidget *tab = widget(index);
     if (!tab) return;
@@ -179,4 +329,78 @@ void TabManager::animateTab(int index) {
     a->setStartValue(0.0);
     a->setEndValue(1.0);
     a->start(QAbstractAnimation::DeleteWhenStopped);
-}
\ No newline at end of file
+}
+
+static const char *const TabMimeType = "application/x-capture-tab";
+QPointer<TabManager> TabManager::dragSource;
+
+// Dragging a tab well clear of the tab bar turns QTabBar's own reordering
+// into a drag that other windows accept; dropping it anywhere else opens it
+// in a new window.
+bool TabManager::eventFilter(QObject *watched, QEvent *event) {
+    if (watched != tabBar()) return QTabWidget::eventFilter(watched, event);
+
+    if (event->type() == QEvent::MouseButtonPress) {
+        auto *e = static_cast<QMouseEvent*>(event);
+        dragIndex = e->button() == Qt::LeftButton ? tabBar()->tabAt(e->position().toPoint()) : -1;
+        dragStart = e->position().toPoint();
+    } else if (event->type() == QEvent::MouseButtonRelease) {
+        dragIndex = -1;
+    } else if (event->type() == QEvent::MouseMove && dragIndex != -1) {
+        auto *e = static_cast<QMouseEvent*>(event);
+        const QPoint pos = e->position().toPoint();
+        if (qAbs(pos.y() - dragStart.y()) > tabBar()->height() + QApplication::startDragDistance()) {
+            const int index = dragIndex;
+            dragIndex = -1;
+            // End QTabBar's in-bar move before the drag loop swallows the release.
+            QMouseEvent release(QEvent::MouseButtonRelease, dragStart, e->globalPosition(),
+                                Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+            QCoreApplication::sendEvent(tabBar(), &release);
+            startTabDrag(index);
+            return true;
+        }
+    }
+    return QTabWidget::eventFilter(watched, event);
+}
+
+void TabManager::startTabDrag(int index) {
+    QWidget *tab = widget(index);
+    if (!tab) return;
+
+    auto *drag = new QDrag(tabBar());
+    auto *mime = new QMimeData;
+    mime->setData(TabMimeType, QByteArray::number(index));
+    drag->setMimeData(mime);
+    drag->setPixmap(tab->grab().scaledToWidth(240, Qt::SmoothTransformation));
+
+    dragSource = this;
+    QPointer<QWidget> dragged(tab);
+    const Qt::DropAction action = drag->exec(Qt::MoveAction);
+    dragSource = nullptr;
+
+    // Nobody took it: tear it off into a window of its own, unless it is
+    // already alone in one.
+    if (action == Qt::IgnoreAction && dragged && count() > 1) {
+        auto *source = qobject_cast<Browser*>(window());
+        if (!source) return;
+        Browser *w = source->openEmptyWindow();
+        w->move(QCursor::pos() - QPoint(80, 20));
+        moveTab(indexOf(dragged), w->tabManager(), -1);
+    }
+}
+
+void TabManager::dragEnterEvent(QDragEnterEvent *event) {
+    if (event->mimeData()->hasFormat(TabMimeType) && dragSource && dragSource != this
+            && dragSource->profile() == webProfile) {
+        event->acceptProposedAction();
+    }
+}
+
+void TabManager::dropEvent(QDropEvent *event) {
+    if (!event->mimeData()->hasFormat(TabMimeType) || !dragSource || dragSource == this) return;
+    const int from = event->mimeData()->data(TabMimeType).toInt();
+    const int to = tabBar()->tabAt(tabBar()->mapFrom(this, event->position().toPoint()));
+    dragSource->moveTab(from, this, to);
+    event->acceptProposedAction();
+    window()->activateWindow();
+}
@@ -3,18 +3,70 @@
 
 #include <QTabWidget>
 #include <QWebEngineView>
+#include <QWebEngineProfile>
+#include <QTimer>
+#include <QPointer>
 
+class QWebChannel;
 class Browser; 
+class TabLifecycleManager;
+class TabChrome;
+class TabPlaceholder;
+struct SessionTab;
 
 class TabManager : public QTabWidget {
     Q_OBJECT
 public:
-    TabManager(QWidget *parent = nullptr);
+    TabManager(QWebEngineProfile *profile, QWidget *parent = nullptr);
     QWebEngineView* createNewTab(const QUrl &url);
+    TabPlaceholder* addPlaceholderTab(const SessionTab &tab);
+    void activateTab(int index);
+    void navigate(QWebEngineView *view, const QUrl &url);
+    void adoptPage(QWebEngineView *view, QWebEnginePage *page, bool loaded);
+    void closeTab(int index);
+    QWidget *detach(QWebEngineView *view);
+    bool reattach(QWebEngineView *view, QWidget *placeholder);
+    void moveTab(int index, TabManager *target, int targetIndex = -1);
+    void setSpareViews(int count) { spareTarget = qMax(0, count); spareTimer.start(); }
+    TabLifecycleManager *lifecycle() const { return lifecycleManager; }
+    TabChrome *tabChrome() const { return chrome; }
+    QWebEngineProfile *profile() const { return webProfile; }
+    QWebChannel *webChannel() const { return channel; }
+signals:
+    void viewCreated(QWebEngineView *view);
+    void tabsChanged();
+    void pageAdopted(QWebEngineView *view);
+    void tabReleased(QWidget *tab);
+    void tabAccepted(QWidget *tab);
 public slots:
     void handleNewTabButtonClick();
+protected:
+    void tabInserted(int index) override;
+    void tabRemoved(int index) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
+    void dragEnterEvent(QDragEnterEvent *event) override;
+    void dropEvent(QDropEvent *event) override;
 private:
+    QWebEngineProfile *webProfile;
+    TabLifecycleManager *lifecycleManager;
+    TabChrome *chrome;
+    QWebChannel *channel;
+    QList<QWebEngineView*> spares;
+    QTimer spareTimer;
+    int spareTarget = 2;
+    QWebEngineView* createView();
+    QWebEngineView* buildView();
+    void refillSpares();
+    void wirePage(QWebEnginePage *page);
+    void wireView(QWebEngineView *view);
+    QWidget *releaseTab(int index);
+    void acceptTab(QWidget *tab, const QString &title, const QIcon &icon, int index);
+    void startTabDrag(int index);
+    int dragIndex = -1;
+    QPoint dragStart;
+    static QPointer<TabManager> dragSource;
+    QWebEngineView* materialize(int index);
     void animateTab(int index);
 };
 
-#endif
\ No newline at end of file
+#endif
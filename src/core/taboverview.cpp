@@ -0,0 +1,96 @@
+#include "taboverview.h"
+#include "tabmanager.h"
+#include "thumbnailcache.h"
+#include "sessionstore.h"
+#include <QKeyEvent>
+
+TabOverviewModel::TabOverviewModel(TabManager *tabs, ThumbnailCache *cache, QObject *parent)
+    : QAbstractListModel(parent), tabs(tabs), cache(cache) {
+    connect(cache, &ThumbnailCache::updated, this, [this](const QUrl &url) {
+        for (int row = 0; row < rowCount(); ++row) {
+            if (urlAt(row) == url) emit dataChanged(index(row), index(row), {Qt::DecorationRole});
+        }
+    });
+}
+
+void TabOverviewModel::reset() {
+    beginResetModel();
+    endResetModel();
+}
+
+int TabOverviewModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : tabs->count();
+}
+
+QUrl TabOverviewModel::urlAt(int row) const {
+    QWidget *tab = tabs->widget(row);
+    if (auto *view = qobject_cast<QWebEngineView*>(tab)) return view->url();
+    if (auto *placeholder = qobject_cast<TabPlaceholder*>(tab)) return placeholder->tab.url;
+    return QUrl();
+}
+
+QVariant TabOverviewModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= tabs->count()) return QVariant();
+    QWidget *tab = tabs->widget(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        if (auto *view = qobject_cast<QWebEngineView*>(tab)) return view->title();
+        if (auto *placeholder = qobject_cast<TabPlaceholder*>(tab)) return placeholder->tab.title;
+        return tabs->tabText(index.row());
+    case Qt::DecorationRole: {
+        const QPixmap preview = cache->thumbnail(urlAt(index.row()));
+        if (!preview.isNull()) return preview;
+        return tabs->tabIcon(index.row());
+    }
+    case Qt::ToolTipRole:
+        return urlAt(index.row()).toString();
+    default:
+        return QVariant();
+    }
+}
+
+TabOverview::TabOverview(TabManager *tabs, ThumbnailCache *cache) : QListView(tabs), tabs(tabs) {
+    model = new TabOverviewModel(tabs, cache, this);
+    setModel(model);
+    setViewMode(QListView::IconMode);
+    setMovement(QListView::Static);
+    setResizeMode(QListView::Adjust);
+    setUniformItemSizes(true);
+    setIconSize(ThumbnailCache::size());
+    setGridSize(ThumbnailCache::size() + QSize(24, 48));
+    setTextElideMode(Qt::ElideRight);
+    setSpacing(8);
+    setFrameShape(QFrame::NoFrame);
+    setBackgroundRole(QPalette::Window);
+    hide();
+
+    tabs->installEventFilter(this);
+    connect(this, &QListView::activated, this, [this](const QModelIndex &index) {
+        hide();
+        this->tabs->activateTab(index.row());
+    });
+    connect(this, &QListView::clicked, this, &QListView::activated);
+}
+
+void TabOverview::open() {
+    model->reset();
+    setGeometry(tabs->rect());
+    setCurrentIndex(model->index(tabs->currentIndex()));
+    show();
+    raise();
+    setFocus();
+}
+
+bool TabOverview::eventFilter(QObject *watched, QEvent *event) {
+    if (watched == tabs && event->type() == QEvent::Resize && isVisible()) setGeometry(tabs->rect());
+    return QListView::eventFilter(watched, event);
+}
+
+void TabOverview::keyPressEvent(QKeyEvent *event) {
+    if (event->key() == Qt::Key_Escape) {
+        hide();
+        tabs->currentWidget()->setFocus();
+        return;
+    }
+    QListView::keyPressEvent(event);
+}
@@ -0,0 +1,42 @@
+#ifndef TABOVERVIEW_H
+#define TABOVERVIEW_H
+
+#include <QAbstractListModel>
+#include <QListView>
+
+class TabManager;
+class ThumbnailCache;
+
+// One row per tab of a TabManager, previews coming from the ThumbnailCache.
+class TabOverviewModel : public QAbstractListModel {
+    Q_OBJECT
+public:
+    TabOverviewModel(TabManager *tabs, ThumbnailCache *cache, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    void reset();
+
+private:
+    TabManager *tabs;
+    ThumbnailCache *cache;
+    QUrl urlAt(int row) const;
+};
+
+// Grid of tab previews laid over the tab area; picking one switches to it.
+class TabOverview : public QListView {
+    Q_OBJECT
+public:
+    TabOverview(TabManager *tabs, ThumbnailCache *cache);
+    void open();
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+
+private:
+    TabManager *tabs;
+    TabOverviewModel *model;
+};
+
+#endif
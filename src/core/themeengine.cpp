@@ -0,0 +1,264 @@
+#include "themeengine.h"
+#include "userdata.h"
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QPainter>
+#include <QProxyStyle>
+#include <QStyleFactory>
+#include <QStyleOption>
+#include <QTabBar>
+#include <QWidget>
+
+// Theme tokens and the palette role each one is kept in. The style below
+// reads them back from these roles, so a theme is nothing but a palette.
+struct Token {
+    const char *name;
+    QPalette::ColorRole role;
+};
+
+static const Token Tokens[] = {
+    {"window", QPalette::Window},
+    {"text", QPalette::WindowText},
+    {"muted", QPalette::PlaceholderText},
+    {"toolbar", QPalette::AlternateBase},
+    {"field", QPalette::Base},
+    {"fieldText", QPalette::Text},
+    {"button", QPalette::Button},
+    {"buttonText", QPalette::ButtonText},
+    {"buttonBorder", QPalette::Shadow},
+    {"border", QPalette::Mid},
+    {"hover", QPalette::Midlight},
+    {"hoverText", QPalette::BrightText},
+    {"selectedTab", QPalette::Light},
+    {"accent", QPalette::Highlight},
+    {"accentText", QPalette::HighlightedText},
+};
+
+// Same format as the files in user_data/themes/; a file may name a "base"
+// theme and only list the tokens it changes.
+static const char BuiltInThemes[] = R"([
+    {"name": "Dark", "colors": {
+        "window": "#0f0f0f", "text": "#e8eaed", "muted": "#9aa0a6", "toolbar": "#1a1a1a",
+        "field": "#2b2b2b", "fieldText": "#e8eaed", "button": "#2b2b2b", "buttonText": "#bdc1c6",
+        "buttonBorder": "#3c4043", "border": "#3c4043", "hover": "#3c4043", "hoverText": "#ffffff",
+        "selectedTab": "#2b2b2b", "accent": "#8ab4f8", "accentText": "#0f0f0f"}},
+    {"name": "White", "colors": {
+        "window": "#ffffff", "text": "#202124", "muted": "#5f6368", "toolbar": "#f8f9fa",
+        "field": "#f1f3f4", "fieldText": "#202124", "button": "transparent", "buttonText": "#5f6368",
+        "buttonBorder": "transparent", "border": "#dfe1e5", "hover": "#e8eaed", "hoverText": "#1a73e8",
+        "selectedTab": "#ffffff", "accent": "#1a73e8", "accentText": "#ffffff"}},
+    {"name": "Private", "colors": {
+        "window": "#0d0216", "text": "#d9b3ff", "muted": "#8a6fa3", "toolbar": "#1a0b2e",
+        "field": "#0d0216", "fieldText": "#bc13fe", "button": "#1a0b2e", "buttonText": "#bc13fe",
+        "buttonBorder": "#4b0082", "border": "#4b0082", "hover": "#bc13fe", "hoverText": "#000000",
+        "selectedTab": "#0d0216", "accent": "#bc13fe", "accentText": "#000000"}}
+])";
+
+// Fusion, which already paints everything else from the palette, with the
+// browser chrome drawn the way the old style sheets described it. Nothing
+// here depends on which theme is active.
+class ThemeStyle : public QProxyStyle {
+public:
+    ThemeStyle() : QProxyStyle(QStyleFactory::create("Fusion")) {}
+
+    void drawPrimitive(PrimitiveElement element, const QStyleOption *option, QPainter *painter,
+                       const QWidget *widget) const override {
+        const QPalette &pal = option->palette;
+        switch (element) {
+        case PE_PanelLineEdit: {
+            // Frameless editors (item views, spin boxes) keep Fusion's look.
+            auto *frame = qstyleoption_cast<const QStyleOptionFrame*>(option);
+            if (!frame || frame->lineWidth <= 0) break;
+            const QColor pen = option->state & State_HasFocus ? pal.color(QPalette::Highlight) : pal.color(QPalette::Mid);
+            drawRounded(painter, option->rect, 20, pal.color(QPalette::Base), pen);
+            return;
+        }
+        case PE_PanelButtonCommand: {
+            const bool hover = (option->state & State_MouseOver) && (option->state & State_Enabled);
+            const bool down = option->state & (State_Sunken | State_On);
+            drawRounded(painter, option->rect, 10, pal.color(hover || down ? QPalette::Midlight : QPalette::Button),
+                        pal.color(hover ? QPalette::Highlight : QPalette::Shadow));
+            return;
+        }
+        case PE_FrameTabWidget:
+            painter->fillRect(option->rect, pal.window());
+            return;
+        case PE_FrameTabBarBase:
+            return;
+        default:
+            break;
+        }
+        QProxyStyle::drawPrimitive(element, option, painter, widget);
+    }
+
+    void drawControl(ControlElement element, const QStyleOption *option, QPainter *painter,
+                     const QWidget *widget) const override {
+        switch (element) {
+        case CE_PushButtonLabel:
+            if (auto *button = qstyleoption_cast<const QStyleOptionButton*>(option); button && (option->state & State_MouseOver)) {
+                QStyleOptionButton hovered(*button);
+                hovered.palette.setColor(QPalette::ButtonText, button->palette.color(QPalette::BrightText));
+                QProxyStyle::drawControl(element, &hovered, painter, widget);
+                return;
+            }
+            break;
+        case CE_ToolBar:
+            painter->fillRect(option->rect, option->palette.alternateBase());
+            painter->setPen(option->palette.color(QPalette::Mid));
+            painter->drawLine(option->rect.bottomLeft(), option->rect.bottomRight());
+            return;
+        case CE_TabBarTabShape:
+            if (auto *tab = qstyleoption_cast<const QStyleOptionTab*>(option); tab && tab->shape == QTabBar::RoundedNorth) {
+                const QRect r = tab->rect;
+                const bool selected = tab->state & State_Selected;
+                painter->fillRect(r, selected ? tab->palette.light() : tab->palette.alternateBase());
+                if (selected) painter->fillRect(QRect(r.left(), r.bottom() - 1, r.width(), 2), tab->palette.highlight());
+                return;
+            }
+            break;
+        case CE_TabBarTabLabel:
+            if (auto *tab = qstyleoption_cast<const QStyleOptionTab*>(option)) {
+                QStyleOptionTab label(*tab);
+                label.palette.setColor(QPalette::WindowText, tab->palette.color(
+                    tab->state & State_Selected ? QPalette::Highlight : QPalette::PlaceholderText));
+                QProxyStyle::drawControl(element, &label, painter, widget);
+                return;
+            }
+            break;
+        default:
+            break;
+        }
+        QProxyStyle::drawControl(element, option, painter, widget);
+    }
+
+    QRect subElementRect(SubElement element, const QStyleOption *option, const QWidget *widget) const override {
+        QRect r = QProxyStyle::subElementRect(element, option, widget);
+        if (element == SE_LineEditContents) {
+            auto *frame = qstyleoption_cast<const QStyleOptionFrame*>(option);
+            if (frame && frame->lineWidth > 0) r.adjust(12, 0, -12, 0);
+        }
+        return r;
+    }
+
+    QSize sizeFromContents(ContentsType type, const QStyleOption *option, const QSize &size,
+                           const QWidget *widget) const override {
+        switch (type) {
+        case CT_PushButton:
+            // 5px by 12px of padding and no minimum width, so icon buttons stay small.
+            return size + QSize(24, 10);
+        case CT_TabBarTab:
+            return QProxyStyle::sizeFromContents(type, option, size, widget) + QSize(16, 8);
+        case CT_LineEdit:
+            return QProxyStyle::sizeFromContents(type, option, size, widget) + QSize(24, 6);
+        default:
+            return QProxyStyle::sizeFromContents(type, option, size, widget);
+        }
+    }
+
+    int pixelMetric(PixelMetric metric, const QStyleOption *option, const QWidget *widget) const override {
+        switch (metric) {
+        case PM_ToolBarItemSpacing: return 10;
+        case PM_ToolBarItemMargin: return 6;
+        default: return QProxyStyle::pixelMetric(metric, option, widget);
+        }
+    }
+
+private:
+    static void drawRounded(QPainter *painter, const QRect &rect, qreal radius, const QColor &fill, const QColor &pen) {
+        const QRectF r = QRectF(rect).adjusted(0.5, 0.5, -0.5, -0.5);
+        radius = qMin(radius, r.height() / 2);
+        painter->save();
+        painter->setRenderHint(QPainter::Antialiasing);
+        painter->setPen(pen.alpha() ? QPen(pen) : QPen(Qt::NoPen));
+        painter->setBrush(fill);
+        painter->drawRoundedRect(r, radius, radius);
+        painter->restore();
+    }
+};
+
+ThemeEngine *ThemeEngine::instance() {
+    static ThemeEngine *engine = new ThemeEngine(qApp);
+    return engine;
+}
+
+ThemeEngine::ThemeEngine(QObject *parent) : QObject(parent) {
+    const QJsonArray builtIn = QJsonDocument::fromJson(QByteArray(BuiltInThemes)).array();
+    for (const QJsonValue &v : builtIn) addTheme(v.toObject());
+    loadThemes(userDataPath() + "/themes");
+
+    // Set once for the whole application; the application takes ownership.
+    qApp->setStyle(new ThemeStyle);
+    QApplication::setPalette(palette("Dark"));
+}
+
+void ThemeEngine::loadThemes(const QString &dir) {
+    const QStringList files = QDir(dir).entryList({"*.json"}, QDir::Files, QDir::Name);
+    for (const QString &name : files) {
+        QFile f(dir + "/" + name);
+        if (!f.open(QIODevice::ReadOnly)) continue;
+        QJsonParseError error;
+        const QJsonDocument doc = QJsonDocument::fromJson(f.readAll(), &error);
+        if (!doc.isObject()) {
+            qWarning("Ignoring theme %s: %s", qPrintable(name), qPrintable(error.errorString()));
+            continue;
+        }
+        QJsonObject theme = doc.object();
+        if (!theme.contains("name")) theme["name"] = QFileInfo(name).completeBaseName();
+        addTheme(theme);
+    }
+}
+
+void ThemeEngine::addTheme(const QJsonObject &theme) {
+    const QString name = theme["name"].toString();
+    if (name.isEmpty()) return;
+    const QJsonObject colors = theme["colors"].toObject();
+    auto color = [&colors](const char *token) { return QColor::fromString(colors[token].toString()); };
+
+    QPalette p;
+    const QString base = theme["base"].toString();
+    if (palettes.contains(base)) {
+        p = palettes.value(base);
+    } else {
+        // Qt derives the roles no token covers (bevels, links, tooltips)
+        // from the button and window colours.
+        const QColor window = color("window").isValid() ? color("window") : QColor("#0f0f0f");
+        p = QPalette(color("button").isValid() && color("button").alpha() ? color("button") : window, window);
+    }
+
+    for (const Token &token : Tokens) {
+        if (!colors.contains(token.name)) continue;
+        const QColor c = color(token.name);
+        if (c.isValid()) p.setColor(token.role, c);
+        else qWarning("Theme %s: bad colour for %s", qPrintable(name), token.name);
+    }
+    const QColor muted = p.color(QPalette::PlaceholderText);
+    for (QPalette::ColorRole role : {QPalette::WindowText, QPalette::Text, QPalette::ButtonText})
+        p.setColor(QPalette::Disabled, role, muted);
+
+    if (!palettes.contains(name)) order.append(name);
+    palettes.insert(name, p);
+}
+
+QPalette ThemeEngine::palette(const QString &name) const {
+    return palettes.value(name, palettes.value("Dark"));
+}
+
+// Palette changes propagate to every child and only repaint; no widget is
+// re-polished and the style is shared, unlike a window style sheet. Child
+// windows (menus, popups, picture-in-picture) are cut off from that
+// propagation, so the open ones are set directly.
+void ThemeEngine::apply(QWidget *window, const QString &name) const {
+    const QPalette p = palette(name);
+    window->setPalette(p);
+    for (QWidget *child : window->findChildren<QWidget*>()) {
+        if (child->isWindow()) child->setPalette(p);
+    }
+}
+
+QString ThemeEngine::themesJson() const {
+    return QString::fromUtf8(QJsonDocument(QJsonArray::fromStringList(order)).toJson(QJsonDocument::Compact));
+}
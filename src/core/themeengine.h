@@ -0,0 +1,41 @@
+#ifndef THEMEENGINE_H
+#define THEMEENGINE_H
+
+#include <QObject>
+#include <QHash>
+#include <QJsonObject>
+#include <QPalette>
+#include <QStringList>
+
+class QWidget;
+
+// Window themes as data. A theme is a small set of colour tokens (see
+// themeengine.cpp), compiled once into a QPalette; one application-wide
+// proxy style draws the toolbar, address field, buttons and tabs from
+// whatever palette a widget carries. Switching a window's theme is then a
+// single setPalette() instead of a style sheet being parsed and every widget
+// polished again. Themes in user_data/themes/*.json are added to, or
+// replace, the built-in ones.
+class ThemeEngine : public QObject {
+    Q_OBJECT
+public:
+    static ThemeEngine *instance();
+
+    QPalette palette(const QString &name) const;
+    void apply(QWidget *window, const QString &name) const;
+    QStringList names() const { return order; }
+
+    // JSON array of theme names, built-in ones first.
+    Q_INVOKABLE QString themesJson() const;
+
+private:
+    explicit ThemeEngine(QObject *parent = nullptr);
+
+    QHash<QString, QPalette> palettes;
+    QStringList order;
+
+    void addTheme(const QJsonObject &theme);
+    void loadThemes(const QString &dir);
+};
+
+#endif
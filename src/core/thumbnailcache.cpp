@@ -0,0 +1,131 @@
+#include "thumbnailcache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QImage>
+#include <QSaveFile>
+
+ThumbnailCache::ThumbnailCache(const QString &dir, QObject *parent) : QObject(parent), dir(dir) {
+    memory.setMaxCost(64 * 1024 * 1024);
+    if (dir.isEmpty()) return;
+    QDir().mkpath(dir);
+    pool.start([this]() {
+        QMutexLocker lock(&diskLock);
+        qint64 total = 0;
+        QDirIterator it(this->dir, {"*.jpg"}, QDir::Files);
+        while (it.hasNext()) total += it.nextFileInfo().size();
+        diskBytes += total;
+        lock.unlock();
+        if (diskBytes.load() > maxDiskBytes()) prune();
+    });
+}
+
+ThumbnailCache::~ThumbnailCache() {
+    // Queued grabs skip their disk write at the epoch check, and whatever they
+    // post back is dropped along with this object.
+    ++epoch;
+    pool.waitForDone();
+}
+
+QString ThumbnailCache::keyFor(const QUrl &url) {
+    return QCryptographicHash::hash(url.toEncoded(QUrl::RemoveFragment), QCryptographicHash::Sha1).toHex();
+}
+
+void ThumbnailCache::insert(const QString &key, const QImage &image) {
+    auto *pixmap = new QPixmap(QPixmap::fromImage(image));
+    memory.insert(key, pixmap, image.sizeInBytes());
+    missing.remove(key);
+}
+
+void ThumbnailCache::capture(QWebEngineView *view) {
+    if (!view->isVisible() || view->url().isEmpty()) return;
+    const QUrl url = view->url();
+    const QString key = keyFor(url);
+    const QString path = dir.isEmpty() ? QString() : dir + "/" + key + ".jpg";
+    const QImage shot = view->grab().toImage();
+    if (shot.isNull()) return;
+
+    const int started = epoch.load();
+    pool.start([this, shot, url, key, path, started]() {
+        // Keep the top of the page at the preview's aspect ratio, then shrink.
+        const QSize target = size();
+        const int height = qMin(shot.height(), shot.width() * target.height() / target.width());
+        const QImage scaled = shot.copy(0, 0, shot.width(), height)
+            .scaled(target, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        if (!path.isEmpty()) {
+            QMutexLocker lock(&diskLock);
+            if (started != epoch.load()) return;
+            const qint64 before = QFileInfo(path).size();
+            QSaveFile f(path);
+            if (f.open(QIODevice::WriteOnly) && scaled.save(&f, "JPG", 80) && f.commit())
+                diskBytes += QFileInfo(path).size() - before;
+            lock.unlock();
+            if (diskBytes.load() > maxDiskBytes()) prune();
+        }
+        QMetaObject::invokeMethod(this, [this, key, url, scaled, started]() {
+            if (started != epoch.load()) return;
+            insert(key, scaled);
+            emit updated(url);
+        }, Qt::QueuedConnection);
+    });
+}
+
+QPixmap ThumbnailCache::thumbnail(const QUrl &url) {
+    const QString key = keyFor(url);
+    if (QPixmap *pixmap = memory.object(key)) return *pixmap;
+    if (dir.isEmpty() || loading.contains(key) || missing.contains(key)) return QPixmap();
+
+    loading.insert(key);
+    const QString path = dir + "/" + key + ".jpg";
+    const int started = epoch.load();
+    pool.start([this, key, url, path, started]() {
+        const QImage image(path);
+        // Reads count as use, so pruning keeps what is still being shown.
+        if (!image.isNull()) {
+            QFile f(path);
+            if (f.open(QIODevice::ReadWrite)) f.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        }
+        QMetaObject::invokeMethod(this, [this, key, url, image, started]() {
+            if (started != epoch.load()) return;
+            loading.remove(key);
+            if (image.isNull()) {
+                missing.insert(key);
+                return;
+            }
+            insert(key, image);
+            emit updated(url);
+        }, Qt::QueuedConnection);
+    });
+    return QPixmap();
+}
+
+void ThumbnailCache::clear() {
+    ++epoch;
+    memory.clear();
+    loading.clear();
+    missing.clear();
+    if (dir.isEmpty()) return;
+    pool.start([this]() {
+        QMutexLocker lock(&diskLock);
+        QDirIterator it(dir, {"*.jpg"}, QDir::Files);
+        while (it.hasNext()) QFile::remove(it.next());
+        diskBytes.store(0);
+    });
+}
+
+// Runs on the pool. Oldest files go first until the directory is back under
+// three quarters of the budget, so pruning does not run on every write.
+void ThumbnailCache::prune() {
+    QMutexLocker lock(&diskLock);
+    if (diskBytes.load() <= maxDiskBytes()) return;
+    const QFileInfoList files = QDir(dir).entryInfoList({"*.jpg"}, QDir::Files, QDir::Time | QDir::Reversed);
+    qint64 total = 0;
+    for (const QFileInfo &info : files) total += info.size();
+    for (const QFileInfo &info : files) {
+        if (total <= maxDiskBytes() * 3 / 4) break;
+        if (QFile::remove(info.filePath())) total -= info.size();
+    }
+    diskBytes.store(total);
+}
@@ -0,0 +1,56 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QMutex>
+#include <QPixmap>
+#include <QSet>
+#include <QThreadPool>
+#include <QUrl>
+#include <QWebEngineView>
+#include <atomic>
+
+// Per-profile page previews keyed by URL. Grabs are downscaled and written to
+// disk on the thread pool; the GUI thread only ever sees finished pixmaps from
+// a size-bounded LRU, and misses are filled from disk in the background, so
+// discarded and restored tabs get previews without waking a renderer. The
+// directory is kept under a byte budget by dropping the least recently used
+// files.
+class ThumbnailCache : public QObject {
+    Q_OBJECT
+public:
+    explicit ThumbnailCache(const QString &dir, QObject *parent = nullptr);
+    ~ThumbnailCache();
+
+    static QSize size() { return QSize(320, 200); }
+
+    void capture(QWebEngineView *view);
+    QPixmap thumbnail(const QUrl &url);
+    // Drops every preview, in memory and on disk. Grabs still in flight are
+    // discarded when they finish.
+    void clear();
+
+signals:
+    void updated(const QUrl &url);
+
+private:
+    QString dir;
+    QCache<QString, QPixmap> memory;
+    QSet<QString> loading;
+    QSet<QString> missing;
+    std::atomic_int epoch{0};
+    std::atomic<qint64> diskBytes{0};
+    // Serialises file writes against clear() and pruning.
+    QMutex diskLock;
+    // Disk work runs on a pool of its own so the destructor can wait for
+    // exactly the tasks that still point at this cache.
+    QThreadPool pool;
+
+    static QString keyFor(const QUrl &url);
+    static qint64 maxDiskBytes() { return 96 * 1024 * 1024; }
+    void insert(const QString &key, const QImage &image);
+    void prune();
+};
+
+#endif
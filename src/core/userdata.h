@@ -0,0 +1,12 @@
+#ifndef USERDATA_H
+#define USERDATA_H
+
+#include <QApplication>
+#include <QString>
+
+// Portable mode: everything the browser persists lives next to the executable.
+inline QString userDataPath() {
+    return QApplication::applicationDirPath() + "/user_data";
+}
+
+#endif
@@ -1,24 +1,116 @@
 #include <QApplication>
-#include <QWebEngineProfile>
-#include <QStandardPaths>
+#include <QCommandLineParser>
 #include <QDir>
+#include <QElapsedTimer>
 #include "core/browser.h"
+#include "core/profile.h"
+#include "core/headlesscapture.h"
+#include "core/schemehandler.h"
+#include "core/replayserver.h"
+#include "core/benchmark.h"
+#include "core/controlserver.h"
+#include "core/startupconfig.h"
+#include "core/userdata.h"
 
 int main(int argc, char *argv[]) {
-    qputenv("QTWEBENGINE_REMOTE_DEBUGGING", "9222");
+    QElapsedTimer launched;
+    launched.start();
+    CaptureSchemeHandler::registerScheme();
+
+    // The platform plugin is chosen when QApplication is constructed, so
+    // --headless and --bench have to be spotted before the real option parsing.
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--headless") == 0 || qstrcmp(argv[i], "--bench") == 0) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+            QByteArray flags = qgetenv("QTWEBENGINE_CHROMIUM_FLAGS");
+            qputenv("QTWEBENGINE_CHROMIUM_FLAGS", (flags + " --disable-gpu").trimmed());
+        }
+    }
     
     QApplication app(argc, argv);
 
-    QWebEngineProfile *p = QWebEngineProfile::defaultProfile();
-    
-    QString path = QApplication::applicationDirPath() + "/user_data";
-    QDir().mkpath(path);
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption({"profile", "Open the window on the named profile.", "name"});
+    parser.addOption({"private", "Open an off-the-record window."});
+    parser.addOption({"headless", "Capture a URL list without a window and exit."});
+    parser.addOption({"urls", "File with one URL per line for --headless ('-' for stdin).", "file", "-"});
+    parser.addOption({"out", "Output directory for --headless.", "dir", "capture_output"});
+    parser.addOption({"jobs", "Number of pages rendered in parallel.", "n", "4"});
+    parser.addOption({"timeout", "Per-page timeout in milliseconds.", "ms", "30000"});
+    parser.addOption({"retries", "Retries for a page that fails or times out.", "n", "1"});
+    parser.addOption({"format", "Comma-separated output formats: png, pdf.", "list", "png"});
+    parser.addOption({"record", "Record every response into an archive directory.", "dir"});
+    parser.addOption({"replay", "Serve responses only from a recorded archive directory.", "dir"});
+    parser.addOption({"latency", "Delay added to each recorded/replayed response.", "ms", "0"});
+    parser.addOption({"bandwidth", "Throughput cap for recorded/replayed responses.", "kbit/s", "0"});
+    parser.addOption({"bench", "Run the offscreen benchmark suite and print JSON results."});
+    parser.addOption({"bench-out", "Write --bench results to a file instead of stdout.", "file"});
+    parser.addOption({"remote-debugging-port", "DevTools port (0 turns remote debugging off).", "port", "9222"});
+    parser.addOption({"control-socket", "Accept JSON-RPC automation commands on this local socket.", "path"});
+    StartupConfig::addOptions(parser);
+    parser.process(app);
+
+    // Read by Qt WebEngine when the first profile starts Chromium.
+    const QString debugPort = parser.value("remote-debugging-port");
+    if (debugPort != "0") qputenv("QTWEBENGINE_REMOTE_DEBUGGING", debugPort.toUtf8());
+    else qunsetenv("QTWEBENGINE_REMOTE_DEBUGGING");
+
+    QDir().mkpath(userDataPath());
+    StartupConfig::load(userDataPath() + "/config.ini", parser).apply();
+
+    // The proxy has to be up before the first profile starts Chromium, which
+    // is when QTWEBENGINE_CHROMIUM_FLAGS is read.
+    if (parser.isSet("record") || parser.isSet("replay")) {
+        const bool record = parser.isSet("record");
+        auto *replay = new ReplayServer(record ? ReplayServer::Record : ReplayServer::Replay,
+                                        parser.value(record ? "record" : "replay"), &app);
+        replay->setLatency(parser.value("latency").toInt());
+        replay->setBandwidth(parser.value("bandwidth").toInt());
+        if (!replay->start()) {
+            qWarning("%s", qPrintable(replay->lastError()));
+            return 2;
+        }
+        QByteArray flags = qgetenv("QTWEBENGINE_CHROMIUM_FLAGS");
+        qputenv("QTWEBENGINE_CHROMIUM_FLAGS", (flags + " " + replay->chromiumFlags()).trimmed());
+    }
+
+    if (parser.isSet("control-socket")) {
+        auto *control = new ControlServer(parser.value("control-socket"), &app);
+        if (!control->start()) {
+            qWarning("Cannot listen on control socket %s", qPrintable(parser.value("control-socket")));
+            return 2;
+        }
+    }
+
+    if (parser.isSet("bench")) {
+        Benchmark bench(launched, parser.value("bench-out"));
+        QObject::connect(&bench, &Benchmark::finished, &app, [](bool ok) { QCoreApplication::exit(ok ? 0 : 1); });
+        if (!bench.start()) return 2;
+        return app.exec();
+    }
+
+    if (parser.isSet("headless")) {
+        CaptureOptions options;
+        options.input = parser.value("urls");
+        options.outputDir = parser.value("out");
+        options.jobs = parser.value("jobs").toInt();
+        options.timeoutMs = parser.value("timeout").toInt();
+        options.retries = parser.value("retries").toInt();
+        const QStringList formats = parser.value("format").split(',');
+        options.png = formats.contains("png");
+        options.pdf = formats.contains("pdf");
+
+        // Batch runs never touch the user's cookies, history or session.
+        HeadlessCapture capture(Profile::offTheRecord(), options);
+        QObject::connect(&capture, &HeadlessCapture::finished, &app, [](int, int failed) { QCoreApplication::exit(failed ? 1 : 0); });
+        if (!capture.start()) return 2;
+        return app.exec();
+    }
 
-    p->setPersistentStoragePath(path + "/storage");
-    p->setCachePath(path + "/cache");
-    p->setPersistentCookiesPolicy(QWebEngineProfile::ForcePersistentCookies);
+    Profile *profile = parser.isSet("private") ? Profile::offTheRecord() : Profile::open(parser.value("profile"));
 
-    Browser w;
+    Browser w(profile);
     w.show();
     return app.exec();
-}
\ No newline at end of file
+}
@@ -0,0 +1,535 @@
+#include "benchmark.h"
+#include "browser.h"
+#include "contentblocker.h"
+#include "downloadmanager.h"
+#include "headlesscapture.h"
+#include "historystore.h"
+#include "omnibox.h"
+#include "processmemory.h"
+#include "profile.h"
+#include "schemehandler.h"
+#include "sessionstore.h"
+#include "tablifecycle.h"
+#include "tabmanager.h"
+#include "taboverview.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QWebEnginePage>
+#include <QtTest>
+#include <algorithm>
+#include <memory>
+
+static QElapsedTimer launched;
+
+static double percentile(QList<double> samples, double p) {
+    if (samples.isEmpty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    return samples.at(qMin(int(samples.size()) - 1, int(samples.size() * p)));
+}
+
+// Local HTTP stand-in. /page/N is a small document; /file/N is N bytes of a
+// fixed pattern with range support; /cut/N is the same file, except that the
+// first request for it breaks off halfway so the download is interrupted.
+class Fixture : public QObject {
+public:
+    bool listen() {
+        connect(&server, &QTcpServer::newConnection, this, &Fixture::accept);
+        return server.listen(QHostAddress::LocalHost, 0);
+    }
+    QUrl url(const QString &path) const {
+        return QUrl(QString("http://127.0.0.1:%1%2").arg(server.serverPort()).arg(path));
+    }
+    static QByteArray content(qint64 size) {
+        QByteArray data(size, Qt::Uninitialized);
+        for (qint64 i = 0; i < size; ++i) data[i] = char(i % 251);
+        return data;
+    }
+
+    int rangeRequests = 0;
+
+private:
+    QTcpServer server;
+    QSet<QByteArray> cut;
+
+    void accept() {
+        while (QTcpSocket *socket = server.nextPendingConnection()) {
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            connect(socket, &QTcpSocket::readyRead, socket, [this, socket]() {
+                const QByteArray request = socket->peek(socket->bytesAvailable());
+                if (!request.contains("\r\n\r\n")) return;
+                socket->readAll();
+                respond(socket, request);
+            });
+        }
+    }
+
+    void respond(QTcpSocket *socket, const QByteArray &request) {
+        const QByteArray path = request.split(' ').value(1);
+        if (path.startsWith("/page/")) {
+            QByteArray body = "<!DOCTYPE html><html><head><title>Fixture " + path + "</title></head><body>";
+            for (int i = 0; i < 200; ++i) body += "<p>Paragraph " + QByteArray::number(i) + ": the quick brown fox.</p>";
+            body += "</body></html>";
+            socket->write("HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=utf-8\r\nCache-Control: no-store\r\n"
+                          "Connection: close\r\nContent-Length: " + QByteArray::number(body.size()) + "\r\n\r\n" + body);
+            socket->disconnectFromHost();
+            return;
+        }
+
+        const bool interrupt = path.startsWith("/cut/") && !cut.contains(path);
+        if (!path.startsWith("/file/") && !path.startsWith("/cut/")) {
+            socket->write("HTTP/1.1 404 Not Found\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+            socket->disconnectFromHost();
+            return;
+        }
+        if (interrupt) cut.insert(path);
+
+        const QByteArray file = path.split('?').value(0);
+        const qint64 size = file.mid(file.lastIndexOf('/') + 1).toLongLong();
+        qint64 from = 0;
+        for (const QByteArray &line : request.split('\n')) {
+            if (line.toLower().startsWith("range: bytes=")) {
+                from = line.mid(13).trimmed().split('-').value(0).toLongLong();
+                rangeRequests++;
+            }
+        }
+        from = qBound(qint64(0), from, size);
+        QByteArray head = from ? "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes " + QByteArray::number(from) + "-"
+                                     + QByteArray::number(size - 1) + "/" + QByteArray::number(size) + "\r\n"
+                               : QByteArray("HTTP/1.1 200 OK\r\n");
+        head += "Content-Type: application/octet-stream\r\nContent-Disposition: attachment; filename=\"fixture.bin\"\r\n"
+                "Accept-Ranges: bytes\r\nETag: \"fixture-" + QByteArray::number(size) + "\"\r\n"
+                "Last-Modified: Mon, 05 Oct 2026 10:00:00 GMT\r\nConnection: close\r\n"
+                "Content-Length: " + QByteArray::number(size - from) + "\r\n\r\n";
+        socket->write(head);
+        const QByteArray body = content(size).mid(from);
+        socket->write(interrupt ? body.left(body.size() / 2) : body);
+        socket->disconnectFromHost();
+    }
+};
+
+class CaptureBench : public QObject {
+    Q_OBJECT
+public:
+    // Runs before QApplication exists, like the start of main().
+    static void initMain() {
+        launched.start();
+        CaptureSchemeHandler::registerScheme();
+        if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+            QByteArray flags = qgetenv("QTWEBENGINE_CHROMIUM_FLAGS");
+            qputenv("QTWEBENGINE_CHROMIUM_FLAGS", (flags + " --disable-gpu").trimmed());
+        }
+    }
+
+private slots:
+    void initTestCase();
+    void benchmarkSuite();
+    void suggestionQuery500k();
+    void filterListReplay();
+    void hibernationKeepsRendererMemoryFlat();
+    void downloadsSurviveInterruption();
+    void openCloseThousandTabs();
+    void headlessThroughput();
+    void overviewOpensWithin200Tabs();
+
+private:
+    Fixture fixture;
+
+    static bool loadTab(TabManager *tabs, const QUrl &url);
+    static qint64 rendererBytes(TabManager *tabs);
+    static int openFiles();
+};
+
+void CaptureBench::initTestCase() {
+    QVERIFY(fixture.listen());
+}
+
+bool CaptureBench::loadTab(TabManager *tabs, const QUrl &url) {
+    QWebEngineView *view = tabs->createNewTab(url);
+    QSignalSpy finished(view, &QWebEngineView::loadFinished);
+    return (!finished.isEmpty() || finished.wait(30000)) && finished.first().first().toBool();
+}
+
+// Resident memory of every renderer still serving a tab, each process once.
+qint64 CaptureBench::rendererBytes(TabManager *tabs) {
+    QSet<qint64> pids;
+    for (int i = 0; i < tabs->count(); ++i) {
+        auto *view = qobject_cast<QWebEngineView*>(tabs->widget(i));
+        if (view && view->page()->renderProcessPid() > 0) pids.insert(view->page()->renderProcessPid());
+    }
+    qint64 total = 0;
+    for (qint64 pid : std::as_const(pids)) total += qMax(qint64(0), processResidentBytes(pid));
+    return total;
+}
+
+// Open descriptors of this process, or -1 where /proc is not available.
+int CaptureBench::openFiles() {
+    QDir fds("/proc/self/fd");
+    return fds.exists() ? int(fds.entryList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::System).size()) : -1;
+}
+
+// The --bench suite: startup to first load, tab creation at 1/10/100 tabs,
+// mass reload, history and theme switch cost and peak RSS, as JSON. Runs
+// first so that its startup figure covers process start.
+void CaptureBench::benchmarkSuite() {
+    QTemporaryDir dir;
+    const QString out = qEnvironmentVariable("CAPTURE_BENCH_OUT", dir.filePath("bench.json"));
+    Benchmark bench(launched, out);
+    QSignalSpy finished(&bench, &Benchmark::finished);
+    QVERIFY(bench.start());
+    QVERIFY(finished.wait(20 * 60 * 1000));
+    QVERIFY(finished.first().first().toBool());
+
+    QFile f(out);
+    QVERIFY(f.open(QIODevice::ReadOnly));
+    const QJsonObject result = QJsonDocument::fromJson(f.readAll()).object();
+    for (const char *key : {"startupToFirstLoadMs", "createNewTab", "massReload", "history", "themeSwitch", "peakRssMB"})
+        QVERIFY2(result.contains(key), key);
+    QCOMPARE(result["createNewTab"].toArray().size(), 3);
+    qInfo("%s", QJsonDocument(result).toJson(QJsonDocument::Compact).constData());
+}
+
+// Address bar suggestions have to come back within a millisecond over half a
+// million history entries.
+void CaptureBench::suggestionQuery500k() {
+    static const char *const syllables[] = {"ka", "lo", "mi", "ren", "tor", "vu", "sa", "nex",
+                                            "pi", "qua", "del", "ro", "ti", "zen", "ba", "chu"};
+    QRandomGenerator rng(7);
+    QStringList words;
+    for (int i = 0; i < 5000; ++i) {
+        QString w;
+        for (int n = 2 + rng.bounded(3); n > 0; --n) w += syllables[rng.bounded(16)];
+        words.append(w);
+    }
+    auto word = [&]() { return words.at(rng.bounded(int(words.size()))); };
+
+    const int entries = 500000;
+    HistoryStore store(QString());
+    for (int i = 0; i < entries; ++i) {
+        QString title = word();
+        for (int n = 3 + rng.bounded(5); n > 0; --n) title += " " + word();
+        store.addVisit(QUrl(QString("https://www.%1%2.com/%3/%4-%5").arg(word()).arg(i % 20000).arg(word(), word()).arg(i)),
+                       title);
+    }
+    SuggestionIndex index(&store);
+    // The initial build runs on the thread pool.
+    QTRY_VERIFY_WITH_TIMEOUT(!index.query(words.first(), 1).isEmpty(), 120000);
+
+    QList<double> ms;
+    int hits = 0;
+    for (int i = 0; i < 2000; ++i) {
+        const QString w = word();
+        QString text = w.left(2 + rng.bounded(int(w.size()) - 1));
+        if (i % 3 == 0) text = word() + " " + text;
+        QElapsedTimer t;
+        t.start();
+        hits += index.query(text, 8).size();
+        ms.append(t.nsecsElapsed() / 1e6);
+    }
+    const double p50 = percentile(ms, 0.5), p95 = percentile(ms, 0.95);
+    qInfo("suggestions over %d entries: p50 %.3f ms, p95 %.3f ms, max %.3f ms", entries, p50, p95, percentile(ms, 1));
+    QVERIFY(hits > 0);
+    QVERIFY2(p95 < 1.0, qPrintable(QString("p95 %1 ms").arg(p95)));
+}
+
+// Replays a request log against a compiled filter list. CAPTURE_BENCH_FILTERS
+// may name an EasyList-format file and CAPTURE_BENCH_REQUESTS the index.jsonl
+// of a --record corpus; otherwise both are generated.
+void CaptureBench::filterListReplay() {
+    FilterMatcher matcher;
+    const QString filters = qEnvironmentVariable("CAPTURE_BENCH_FILTERS");
+    if (!filters.isEmpty()) {
+        QFile f(filters);
+        QVERIFY2(f.open(QIODevice::ReadOnly), qPrintable(filters));
+        matcher.addList(f.readAll());
+    } else {
+        QByteArray list = "[Adblock Plus 2.0]\n";
+        for (int i = 0; i < 20000; ++i) list += "||tracker" + QByteArray::number(i) + ".example^\n";
+        for (int i = 0; i < 5000; ++i) list += "||ads" + QByteArray::number(i) + ".net^$third-party\n";
+        for (int i = 0; i < 5000; ++i) list += "/banner" + QByteArray::number(i) + "/*/ad_\n";
+        for (int i = 0; i < 2000; ++i) list += "&adslot" + QByteArray::number(i) + "=\n";
+        for (int i = 0; i < 500; ++i) list += "@@||tracker" + QByteArray::number(i * 7) + ".example^$image\n";
+        matcher.addList(list);
+    }
+
+    struct Request {
+        QByteArray url;
+        QByteArray host;
+        bool thirdParty;
+        quint32 type;
+    };
+    QVector<Request> log;
+    auto add = [&log](const QUrl &url, const QByteArray &site, quint32 type) {
+        const QByteArray host = url.host(QUrl::FullyEncoded).toLatin1();
+        log.append({url.toEncoded().toLower(), host, ContentBlocker::siteOf(host) != site, type});
+    };
+
+    const QString recorded = qEnvironmentVariable("CAPTURE_BENCH_REQUESTS");
+    if (!recorded.isEmpty()) {
+        // Responses carry no initiator, so each HTML document is taken as the
+        // first party of the requests recorded after it.
+        QFile f(recorded);
+        QVERIFY2(f.open(QIODevice::ReadOnly), qPrintable(recorded));
+        QByteArray site;
+        while (!f.atEnd()) {
+            const QJsonObject o = QJsonDocument::fromJson(f.readLine()).object();
+            const QUrl url(o["url"].toString());
+            QByteArray contentType;
+            for (const QJsonValue &h : o["headers"].toArray()) {
+                if (h.toArray().at(0).toString().compare("content-type", Qt::CaseInsensitive) == 0)
+                    contentType = h.toArray().at(1).toString().toLatin1();
+            }
+            quint32 type = FilterMatcher::Other;
+            if (contentType.contains("html")) {
+                site = ContentBlocker::siteOf(url.host(QUrl::FullyEncoded).toLatin1());
+                continue;
+            }
+            if (contentType.contains("javascript")) type = FilterMatcher::Script;
+            else if (contentType.startsWith("image/")) type = FilterMatcher::Image;
+            else if (contentType.contains("css")) type = FilterMatcher::Stylesheet;
+            else if (contentType.contains("font")) type = FilterMatcher::Font;
+            else if (contentType.contains("json")) type = FilterMatcher::XmlHttpRequest;
+            add(url, site, type);
+        }
+    } else {
+        QRandomGenerator rng(11);
+        const quint32 types[] = {FilterMatcher::Script, FilterMatcher::Image, FilterMatcher::Stylesheet,
+                                 FilterMatcher::XmlHttpRequest, FilterMatcher::Other};
+        for (int i = 0; i < 200000; ++i) {
+            const QByteArray site = "news" + QByteArray::number(rng.bounded(50)) + ".example";
+            QString host;
+            switch (rng.bounded(4)) {
+            case 0: host = "www." + QString::fromLatin1(site); break;
+            case 1: host = QString("cdn%1.example").arg(rng.bounded(100)); break;
+            case 2: host = QString("tracker%1.example").arg(rng.bounded(40000)); break;
+            default: host = QString("ads%1.net").arg(rng.bounded(10000)); break;
+            }
+            const QString path = rng.bounded(5) == 0 ? QString("/banner%1/x/ad_%2.png").arg(rng.bounded(10000)).arg(i)
+                                                     : QString("/static/%1/app.js?v=%2&adslot%3=1").arg(i).arg(rng.bounded(100)).arg(rng.bounded(4000));
+            add(QUrl("https://" + host + path), site, types[rng.bounded(5)]);
+        }
+    }
+    QVERIFY(!log.isEmpty());
+
+    int blocked = 0;
+    QElapsedTimer t;
+    t.start();
+    for (const Request &r : std::as_const(log)) {
+        if (matcher.match(r.url, r.host, r.thirdParty, r.type) == FilterMatcher::Block) blocked++;
+    }
+    const double ns = double(t.nsecsElapsed()) / log.size();
+    qInfo("filter replay: %d rules, %d requests, %d blocked, %.0f ns per request",
+          matcher.ruleCount(), int(log.size()), blocked, ns);
+    if (recorded.isEmpty()) QVERIFY(blocked > 0);
+    QVERIFY2(ns < 1000, qPrintable(QString("%1 ns per request").arg(ns)));
+}
+
+// Opening tab after tab with a live-tab limit in place must not grow the
+// renderers' combined memory: background tabs are discarded instead.
+void CaptureBench::hibernationKeepsRendererMemoryFlat() {
+    auto window = std::make_unique<Browser>(Profile::offTheRecord(), nullptr, false);
+    window->resize(1280, 800);
+    window->show();
+    TabManager *tabs = window->tabManager();
+    const int maxLive = 4;
+    tabs->lifecycle()->setMaxLiveTabs(maxLive);
+
+    qint64 atLimit = 0;
+    for (int i = 0; i < 40; ++i) {
+        QVERIFY(loadTab(tabs, fixture.url(QString("/page/hibernate-%1").arg(i))));
+        tabs->lifecycle()->sweep();
+        if (i + 1 == 2 * maxLive) {
+            QTest::qWait(1000);
+            atLimit = rendererBytes(tabs);
+        }
+    }
+    QTest::qWait(1000);
+    const qint64 atEnd = rendererBytes(tabs);
+    qInfo("renderer RSS: %.1f MB at %d tabs, %.1f MB at %d tabs", atLimit / 1048576.0, 2 * maxLive,
+          atEnd / 1048576.0, int(tabs->count()));
+
+    QVERIFY(tabs->lifecycle()->liveTabCount() <= maxLive);
+    QVERIFY(atLimit > 0);
+    QVERIFY2(atEnd < atLimit * 1.25 + 32 * 1048576.0, "renderer memory grew with the tab count");
+}
+
+// A large file arrives intact, the concurrency limit holds, and a transfer
+// cut off halfway can be resumed from the panel's Resume.
+void CaptureBench::downloadsSurviveInterruption() {
+    Profile *profile = Profile::offTheRecord();
+    profile->retain();
+    QTemporaryDir dir;
+    DownloadManager *downloads = profile->downloads();
+    downloads->setDirectory(dir.path());
+    downloads->setMaxConcurrent(2);
+
+    int active = 0, peak = 0;
+    QObject scope;
+    connect(downloads, &DownloadManager::itemChanged, &scope, [downloads, &active, &peak]() {
+        active = 0;
+        for (int i = 0; i < downloads->count(); ++i) {
+            if (downloads->item(i).status == DownloadItem::Active) active++;
+        }
+        peak = qMax(peak, active);
+    });
+    auto indexOf = [downloads](const QUrl &url) {
+        for (int i = downloads->count() - 1; i >= 0; --i) {
+            if (downloads->item(i).url == url) return i;
+        }
+        return -1;
+    };
+    auto verifyFile = [downloads](int i, qint64 size) {
+        QFile f(downloads->item(i).filePath());
+        return f.open(QIODevice::ReadOnly) && f.readAll() == Fixture::content(size);
+    };
+
+    QWebEnginePage page(profile->web());
+    const qint64 large = 32 * 1024 * 1024;
+    QList<QUrl> urls;
+    for (int i = 0; i < 4; ++i) {
+        urls.append(fixture.url(QString("/file/%1?n=%2").arg(large).arg(i)));
+        page.download(urls.last(), QString("large-%1.bin").arg(i));
+    }
+    for (const QUrl &url : std::as_const(urls)) {
+        QTRY_VERIFY_WITH_TIMEOUT(indexOf(url) >= 0 && downloads->item(indexOf(url)).status == DownloadItem::Completed, 120000);
+        QVERIFY(verifyFile(indexOf(url), large));
+    }
+    QVERIFY2(peak <= 2, qPrintable(QString("%1 downloads ran at once").arg(peak)));
+
+    const qint64 size = 8 * 1024 * 1024;
+    const QUrl cut = fixture.url(QString("/cut/%1").arg(size));
+    page.download(cut, "interrupted.bin");
+    QTRY_VERIFY_WITH_TIMEOUT(indexOf(cut) >= 0 && downloads->item(indexOf(cut)).status == DownloadItem::Failed, 60000);
+    const int ranges = fixture.rangeRequests;
+    downloads->resume(indexOf(cut));
+    QTRY_VERIFY_WITH_TIMEOUT(downloads->item(indexOf(cut)).status == DownloadItem::Completed, 60000);
+    QVERIFY(verifyFile(indexOf(cut), size));
+    qInfo("interrupted download %s", fixture.rangeRequests > ranges ? "resumed with a range request" : "restarted from zero");
+
+    profile->release();
+}
+
+// 1,000 tabs opened and closed in batches: once the first hundred have warmed
+// the spare pool and caches up, views, descriptors and memory stay put.
+void CaptureBench::openCloseThousandTabs() {
+    auto window = std::make_unique<Browser>(Profile::offTheRecord(), nullptr, false);
+    window->resize(1280, 800);
+    window->show();
+    TabManager *tabs = window->tabManager();
+    // The last tab is never closed, so keep one that is not part of the run.
+    QVERIFY(loadTab(tabs, fixture.url("/page/anchor")));
+
+    auto cycle = [this, tabs](int from, int count) {
+        for (int i = from; i < from + count; i += 10) {
+            QObject scope;
+            QList<QWebEngineView*> batch;
+            int finished = 0;
+            for (int j = 0; j < 10; ++j) {
+                QWebEngineView *view = tabs->createNewTab(fixture.url(QString("/page/stress-%1").arg(i + j)));
+                connect(view, &QWebEngineView::loadFinished, &scope, [&finished]() { finished++; }, Qt::SingleShotConnection);
+                batch.append(view);
+            }
+            if (!QTest::qWaitFor([&finished, &batch]() { return finished == batch.size(); }, 30000)) return false;
+            for (QWebEngineView *view : std::as_const(batch)) tabs->closeTab(tabs->indexOf(view));
+            QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+        }
+        return true;
+    };
+    auto views = [&window]() { return int(window->findChildren<QWebEngineView*>().size()); };
+    auto pages = [&window]() { return int(window->findChildren<QWebEnginePage*>().size()); };
+    auto rss = []() { return processResidentBytes(QCoreApplication::applicationPid()); };
+
+    QVERIFY(cycle(0, 100));
+    QTest::qWait(2000);
+    const int baseViews = views(), basePages = pages(), baseFiles = openFiles();
+    const qint64 baseRss = rss();
+
+    QVERIFY(cycle(100, 900));
+    QTest::qWait(2000);
+    qInfo("after 1000 tabs: %d views (%d before), %d pages (%d), %d open files (%d), RSS %.1f MB (%.1f MB)",
+          views(), baseViews, pages(), basePages, openFiles(), baseFiles, rss() / 1048576.0, baseRss / 1048576.0);
+
+    QCOMPARE(tabs->count(), 1);
+    QVERIFY(views() <= baseViews);
+    QVERIFY(pages() <= basePages);
+    if (baseFiles >= 0) QVERIFY(openFiles() <= baseFiles + 16);
+    QVERIFY(rss() < baseRss + 128 * 1048576ll);
+}
+
+// --headless over the same fixture pages with 1, 2 and 4 workers, reported in
+// pages per minute. The pages are light, so a bigger pool has to get through
+// them faster.
+void CaptureBench::headlessThroughput() {
+    QTemporaryDir dir;
+    const int pages = 48;
+    QFile list(dir.filePath("urls.txt"));
+    QVERIFY(list.open(QIODevice::WriteOnly));
+    for (int i = 0; i < pages; ++i) list.write(fixture.url(QString("/page/headless-%1").arg(i)).toEncoded() + "\n");
+    list.close();
+
+    QList<double> perMinute;
+    for (int jobs : {1, 2, 4}) {
+        CaptureOptions options;
+        options.input = list.fileName();
+        options.outputDir = dir.filePath(QString("jobs-%1").arg(jobs));
+        options.jobs = jobs;
+        HeadlessCapture capture(Profile::offTheRecord(), options);
+        QSignalSpy finished(&capture, &HeadlessCapture::finished);
+        QElapsedTimer t;
+        t.start();
+        QVERIFY(capture.start());
+        QVERIFY(finished.wait(10 * 60 * 1000));
+        QCOMPARE(finished.first().at(0).toInt(), pages);
+        perMinute.append(pages * 60000.0 / qMax(qint64(1), t.elapsed()));
+        qInfo("headless capture with %d jobs: %.1f pages/min", jobs, perMinute.last());
+    }
+    QVERIFY2(perMinute.last() > perMinute.first(),
+             qPrintable(QString("4 jobs %1 pages/min, 1 job %2").arg(perMinute.last()).arg(perMinute.first())));
+}
+
+// Opening the tab grid over 200 tabs has to fit in a frame, layout and first
+// paint included. Most of a session that size is discarded, so all but a few
+// tabs are placeholders and their previews come from the cache or are blank.
+void CaptureBench::overviewOpensWithin200Tabs() {
+    auto window = std::make_unique<Browser>(Profile::offTheRecord(), nullptr, false);
+    window->resize(1280, 800);
+    window->show();
+    TabManager *tabs = window->tabManager();
+    for (int i = 0; i < 8; ++i) QVERIFY(loadTab(tabs, fixture.url(QString("/page/overview-%1").arg(i))));
+    while (tabs->count() < 200) {
+        SessionTab tab;
+        tab.url = fixture.url(QString("/page/overview-%1").arg(tabs->count()));
+        tab.title = QString("Overview %1").arg(tabs->count());
+        tabs->addPlaceholderTab(tab);
+    }
+    auto *overview = window->findChild<TabOverview*>();
+    QVERIFY(overview);
+
+    QList<double> ms;
+    for (int i = 0; i < 30; ++i) {
+        QElapsedTimer t;
+        t.start();
+        window->toggleOverview();
+        overview->viewport()->repaint();
+        ms.append(t.nsecsElapsed() / 1e6);
+        QVERIFY(overview->isVisible());
+        window->toggleOverview();
+        QCoreApplication::processEvents();
+    }
+    const double p50 = percentile(ms, 0.5), p95 = percentile(ms, 0.95);
+    qInfo("tab overview over %d tabs: p50 %.2f ms, p95 %.2f ms, max %.2f ms", int(tabs->count()), p50, p95, percentile(ms, 1));
+    QVERIFY2(p95 < 16.7, qPrintable(QString("p95 %1 ms").arg(p95)));
+}
+
+QTEST_MAIN(CaptureBench)
+#include "capture_bench.moc"